@@ -0,0 +1,159 @@
+// Сравнение плоского дерева json::FlatDocument с деревом json::Node на
+// входном документе: время разбора, память, которую занимает дерево, и
+// время обхода base_requests так, как их читает CatalogueLoader.
+// Запуск: benchmarks/run_benchmarks.sh [число имён] [документ]
+#include "../json.h"
+#include "../json_flat.h"
+#include "../request_keys.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+
+namespace {
+
+// Память, выделенная через operator new и ещё не освобождённая
+size_t live_bytes = 0;
+
+// Перед блоком хранится его размер, чтобы delete знал, сколько вычесть
+constexpr size_t HEADER = alignof(std::max_align_t);
+
+void* Allocate(size_t size) {
+    void* block = std::malloc(size + HEADER);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *static_cast<size_t*>(block) = size;
+    live_bytes += size;
+    return static_cast<char*>(block) + HEADER;
+}
+
+void Deallocate(void* ptr) noexcept {
+    if (ptr) {
+        void* block = static_cast<char*>(ptr) - HEADER;
+        live_bytes -= *static_cast<size_t*>(block);
+        std::free(block);
+    }
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+    return Allocate(size);
+}
+void operator delete(void* ptr) noexcept {
+    Deallocate(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+    Deallocate(ptr);
+}
+// Арена FlatDocument просит память у new_delete_resource с выравниванием
+void* operator new(size_t size, std::align_val_t alignment) {
+    if (static_cast<size_t>(alignment) > HEADER) {
+        throw std::bad_alloc();
+    }
+    return Allocate(size);
+}
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    Deallocate(ptr);
+}
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    Deallocate(ptr);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using request_keys::Key;
+
+constexpr int RUNS = 5;
+
+double Elapsed(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Поля, которые читает загрузчик справочника; checksum не даёт выбросить обход
+template <typename Fields, typename Node>
+size_t ReadRequests(const Node& root) {
+    size_t checksum = 0;
+    const Node* requests = Fields(root.AsDict()).Find(Key::BaseRequests);
+    if (!requests) {
+        return checksum;
+    }
+    for (const auto& request : requests->AsArray()) {
+        const Fields fields(request.AsDict());
+        if (const Node* name = fields.Find(Key::Name)) {
+            checksum += name->AsString().size();
+        }
+        if (const Node* stops = fields.Find(Key::Stops)) {
+            checksum += stops->AsArray().size();
+        }
+        if (const Node* distances = fields.Find(Key::RoadDistances)) {
+            for (const auto& [stop, distance] : distances->AsDict()) {
+                checksum += stop.size() + distance.AsInt();
+            }
+        }
+    }
+    return checksum;
+}
+
+struct Result {
+    double parse_ms = 1e300;
+    double read_ms = 1e300;
+    size_t bytes = 0;
+    size_t checksum = 0;
+};
+
+// Лучшее время из RUNS; память — сколько держит готовое дерево
+template <typename Load, typename Read>
+Result Measure(Load load, Read read) {
+    Result result;
+    for (int run = 0; run < RUNS; ++run) {
+        const size_t before = live_bytes;
+        auto start = Clock::now();
+        const auto document = load();
+        result.parse_ms = std::min(result.parse_ms, Elapsed(start));
+        result.bytes = live_bytes - before;
+
+        start = Clock::now();
+        result.checksum = read(document);
+        result.read_ms = std::min(result.read_ms, Elapsed(start));
+    }
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const char* path = argc > 2 ? argv[2] : "../tests/data/network.json";
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        std::cerr << "Cannot open " << path << '\n';
+        return 1;
+    }
+    const std::string text = json::ReadAll(input);
+
+    const Result tree = Measure([&] { return json::Load(text); },
+                                [](const json::Document& doc) {
+                                    return ReadRequests<request_keys::Fields>(doc.GetRoot());
+                                });
+    const Result flat = Measure([&] { return json::LoadFlat(text); },
+                                [](const json::FlatDocument& doc) {
+                                    return ReadRequests<request_keys::FlatFields>(doc.GetRoot());
+                                });
+    if (tree.checksum != flat.checksum) {
+        std::cerr << "Checksums differ: " << tree.checksum << " and " << flat.checksum << '\n';
+        return 1;
+    }
+
+    std::cout << path << ", " << text.size() / 1024 << " KB (checksum " << tree.checksum << ")\n"
+              << "                   Node  FlatDocument\n"
+              << "parse, ms          " << tree.parse_ms << "  " << flat.parse_ms << '\n'
+              << "memory, KB         " << tree.bytes / 1024 << "  " << flat.bytes / 1024 << '\n'
+              << "base_requests, ms  " << tree.read_ms << "  " << flat.read_ms << '\n';
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Сравнение perfect_hash::StringIndex с unordered_map<string_view, ...>,
+// которым справочник искал имена до Freeze, на наборах случайных названий.
+// Запуск: benchmarks/run_benchmarks.sh [число имён]
+#include "../perfect_hash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t LOOKUPS = 2'000'000;
+
+// Названия похожи на настоящие: общие слова и номера разной длины
+std::vector<std::string> MakeNames(size_t count, std::mt19937_64& random) {
+    static const char* const WORDS[] = {"улица", "проспект", "Садовая", "Ленина", "вокзал",
+                                        "Парк", "Школа", "Рынок", "Мост", "Заречная"};
+    std::unordered_set<std::string> seen;
+    std::vector<std::string> names;
+    names.reserve(count);
+    while (names.size() < count) {
+        std::string name = WORDS[random() % std::size(WORDS)];
+        name += ' ';
+        name += std::to_string(random() % (count * 4));
+        if (random() % 2 == 0) {
+            name += ' ';
+            name += WORDS[random() % std::size(WORDS)];
+        }
+        if (seen.insert(name).second) {
+            names.push_back(std::move(name));
+        }
+    }
+    return names;
+}
+
+double Elapsed(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Время на один поиск в наносекундах; checksum не даёт выбросить поиск
+template <typename Find>
+double MeasureLookups(const std::vector<std::string_view>& queries, Find find, size_t& checksum) {
+    const auto start = Clock::now();
+    for (size_t i = 0; i < LOOKUPS; ++i) {
+        checksum += find(queries[i % queries.size()]);
+    }
+    return Elapsed(start) * 1e6 / LOOKUPS;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000;
+    std::mt19937_64 random(42);
+    const std::vector<std::string> names = MakeNames(count, random);
+    const std::vector<std::string> missing = MakeNames(count, random);
+
+    std::vector<std::string_view> keys(names.begin(), names.end());
+
+    auto start = Clock::now();
+    const perfect_hash::StringIndex index(keys);
+    const double index_build = Elapsed(start);
+
+    start = Clock::now();
+    std::unordered_map<std::string_view, size_t> map;
+    map.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        map.emplace(keys[i], i);
+    }
+    const double map_build = Elapsed(start);
+
+    // Запросы в случайном порядке, чтобы не помогал порядок в памяти
+    std::vector<std::string_view> hits = keys;
+    std::shuffle(hits.begin(), hits.end(), random);
+    std::vector<std::string_view> misses;
+    for (const std::string& name : missing) {
+        if (!map.count(name)) {
+            misses.push_back(name);
+        }
+    }
+
+    size_t checksum = 0;
+    auto find_index = [&index](std::string_view key) {
+        return index.Find(key);
+    };
+    auto find_map = [&map](std::string_view key) {
+        const auto it = map.find(key);
+        return it != map.end() ? it->second : perfect_hash::StringIndex::npos;
+    };
+    const double index_hit = MeasureLookups(hits, find_index, checksum);
+    const double map_hit = MeasureLookups(hits, find_map, checksum);
+    const double index_miss = MeasureLookups(misses, find_index, checksum);
+    const double map_miss = MeasureLookups(misses, find_map, checksum);
+
+    std::cout << count << " names (checksum " << checksum << ")\n"
+              << "                 StringIndex  unordered_map\n"
+              << "build, ms        " << index_build << "  " << map_build << '\n'
+              << "hit lookup, ns   " << index_hit << "  " << map_hit << '\n'
+              << "miss lookup, ns  " << index_miss << "  " << map_miss << '\n';
+    return 0;
+}
@@ -0,0 +1,16 @@
+#!/bin/bash
+# Собирает и запускает замеры из этого каталога. Аргументы передаются
+# каждому замеру: первый — число имён для name_lookup_benchmark, второй —
+# документ, который разбирает json_dom_benchmark
+set -e
+cd "$(dirname "$0")"
+OUT=${BUILD_DIR:-/tmp/transport_catalogue_benchmarks}
+mkdir -p "$OUT"
+FLAGS="-std=c++20 -O2 -march=native"
+
+g++ $FLAGS name_lookup_benchmark.cpp ../perfect_hash.cpp -o "$OUT/name_lookup_benchmark"
+"$OUT/name_lookup_benchmark" "$@"
+
+g++ $FLAGS json_dom_benchmark.cpp ../json.cpp ../json_scanner.cpp ../json_flat.cpp ../perfect_hash.cpp \
+    -o "$OUT/json_dom_benchmark"
+"$OUT/json_dom_benchmark" "$@"
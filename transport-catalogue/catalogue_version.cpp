@@ -0,0 +1,43 @@
+#include "catalogue_version.h"
+//catalogue_version.cpp
+#include <utility>
+
+namespace transport {
+
+    CatalogueVersion::CatalogueVersion(TransportCatalogue catalogue,
+                                       const transport_router::RoutingSettings& routing_settings)
+        : number_(0)
+        , catalogue_(std::move(catalogue))
+        , router_(catalogue_, routing_settings) {
+    }
+
+    CatalogueVersion::CatalogueVersion(const CatalogueVersion& base, const CatalogueUpdate& update,
+                                       CatalogueDelta& delta)
+        : number_(base.number_ + 1)
+        , catalogue_(base.catalogue_.WithUpdate(update, delta))
+        , router_(base.router_, catalogue_, delta) {
+    }
+
+    VersionedCatalogue::VersionedCatalogue(TransportCatalogue catalogue,
+                                           const transport_router::RoutingSettings& routing_settings)
+        : current_(std::make_shared<const CatalogueVersion>(std::move(catalogue), routing_settings)) {
+    }
+
+    CatalogueVersionPtr VersionedCatalogue::Pin() const {
+        return current_.load(std::memory_order_acquire);
+    }
+
+    VersionedCatalogue::UpdateResult VersionedCatalogue::Update(const CatalogueUpdate& update) {
+        CatalogueVersionPtr base = Pin();
+        while (true) {
+            UpdateResult result;
+            result.version = std::make_shared<const CatalogueVersion>(*base, update, result.delta);
+            // При неудаче base становится версией, опубликованной другим писателем
+            if (current_.compare_exchange_strong(base, result.version, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire)) {
+                return result;
+            }
+        }
+    }
+
+}  // namespace transport
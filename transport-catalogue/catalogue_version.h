@@ -0,0 +1,75 @@
+#pragma once
+//catalogue_version.h
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace transport {
+
+    // Замороженный справочник и маршрутизатор, построенный по нему. После
+    // создания не меняется, поэтому одну версию могут одновременно читать
+    // любые потоки
+    class CatalogueVersion {
+    public:
+        CatalogueVersion(TransportCatalogue catalogue, const transport_router::RoutingSettings& routing_settings);
+        // Следующая версия: base с изменениями update. Справочник строится
+        // WithUpdate, маршрутизатор — копией маршрутизатора base с общей
+        // таблицей маршрутов; base при этом не меняется. В delta
+        // записываются изменения новой версии
+        CatalogueVersion(const CatalogueVersion& base, const CatalogueUpdate& update, CatalogueDelta& delta);
+
+        // Номер версии, начиная с нуля; у каждой следующей на единицу больше
+        uint64_t Number() const {
+            return number_;
+        }
+        const TransportCatalogue& Catalogue() const {
+            return catalogue_;
+        }
+        const transport_router::TransportRouter& Router() const {
+            return router_;
+        }
+
+    private:
+        uint64_t number_;
+        // Маршрутизатор ссылается на справочник, поэтому объявлен после него
+        TransportCatalogue catalogue_;
+        transport_router::TransportRouter router_;
+    };
+
+    using CatalogueVersionPtr = std::shared_ptr<const CatalogueVersion>;
+
+    // Текущая версия справочника за атомарно публикуемым указателем.
+    // Читатель закрепляет версию на время запроса вызовом Pin() и отвечает по
+    // ней, даже если тем временем опубликована следующая. Следующая версия
+    // строится в стороне от текущей и подменяет её одной атомарной записью, не
+    // останавливая ни читателей, ни других писателей; старая версия
+    // освобождается, когда её отпустит последний читатель
+    class VersionedCatalogue {
+    public:
+        VersionedCatalogue(TransportCatalogue catalogue, const transport_router::RoutingSettings& routing_settings);
+        VersionedCatalogue(const VersionedCatalogue&) = delete;
+        VersionedCatalogue& operator=(const VersionedCatalogue&) = delete;
+
+        CatalogueVersionPtr Pin() const;
+
+        struct UpdateResult {
+            CatalogueVersionPtr version;
+            // Изменения version относительно предыдущей версии
+            CatalogueDelta delta;
+        };
+
+        // Строит версию с изменениями update поверх текущей и публикует её.
+        // Если за это время другой писатель опубликовал свою версию, изменения
+        // накладываются заново уже на неё, так что ни одно не теряется.
+        // Исключение WithUpdate пропускается наружу, текущая версия при этом
+        // не меняется
+        UpdateResult Update(const CatalogueUpdate& update);
+
+    private:
+        std::atomic<CatalogueVersionPtr> current_;
+    };
+
+}  // namespace transport
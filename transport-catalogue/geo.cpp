@@ -12,4 +12,11 @@ namespace geo{
             * 6371000;
     }
 
+  double ComputeDistance(MicroCoordinates from, MicroCoordinates to) {
+        if (from == to) {
+            return 0;
+        }
+        return ComputeDistance(ToDegrees(from), ToDegrees(to));
+    }
+
 }
\ No newline at end of file
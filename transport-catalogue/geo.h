@@ -1,6 +1,7 @@
 #pragma once
 //geo.h
 #include <cmath>
+#include <cstdint>
 namespace geo {
     struct Coordinates {
         double lat;
@@ -13,5 +14,38 @@ namespace geo {
         }
     };
 
+    // Координаты в миллионных долях градуса: вдвое компактнее пары double.
+    // Входные координаты даны с шестью знаками после запятой, поэтому
+    // ToDegrees возвращает ровно те же double, что были прочитаны
+    struct MicroCoordinates {
+        static constexpr double SCALE = 1e6;
+
+        int32_t lat = 0;
+        int32_t lng = 0;
+
+        MicroCoordinates() = default;
+        explicit MicroCoordinates(Coordinates coordinates)
+            : lat(static_cast<int32_t>(std::lround(coordinates.lat * SCALE)))
+            , lng(static_cast<int32_t>(std::lround(coordinates.lng * SCALE))) {
+        }
+
+        bool operator==(const MicroCoordinates& other) const {
+            return lat == other.lat && lng == other.lng;
+        }
+        bool operator!=(const MicroCoordinates& other) const {
+            return !(*this == other);
+        }
+    };
+
+    inline Coordinates ToDegrees(Coordinates coordinates) {
+        return coordinates;
+    }
+    // Деление, а не умножение на 1e-6: целое и 1e6 представимы точно,
+    // и результат — ближайший double к десятичной записи
+    inline Coordinates ToDegrees(MicroCoordinates coordinates) {
+        return {coordinates.lat / MicroCoordinates::SCALE, coordinates.lng / MicroCoordinates::SCALE};
+    }
+
      double ComputeDistance(Coordinates from, Coordinates to);
+     double ComputeDistance(MicroCoordinates from, MicroCoordinates to);
 }
\ No newline at end of file
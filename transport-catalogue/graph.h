@@ -2,6 +2,7 @@
 //graph.h
 #include "ranges.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <vector>
 
@@ -10,6 +11,9 @@ namespace graph {
 using VertexId = size_t;
 using EdgeId = size_t;
 
+// Новый идентификатор удалённого ребра в результате Compact
+inline constexpr EdgeId NO_EDGE = static_cast<EdgeId>(-1);
+
 template <typename Weight>
 struct Edge {
     VertexId from;
@@ -27,15 +31,25 @@ public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
     EdgeId AddEdge(const Edge<Weight>& edge);
+    VertexId AddVertex();
+    // Исключает ребро из списка инцидентности. Идентификаторы остальных рёбер
+    // не меняются, а GetEdge по удалённому ребру по-прежнему его возвращает
+    void RemoveEdge(EdgeId edge_id);
+    // Убирает удалённые рёбра и нумерует оставшиеся подряд в прежнем порядке.
+    // Возвращает новые идентификаторы по старым (NO_EDGE для удалённых)
+    std::vector<EdgeId> Compact();
 
     size_t GetVertexCount() const;
+    // Все рёбра, включая удалённые, которые ещё не убраны Compact
     size_t GetEdgeCount() const;
+    size_t GetRemovedEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
 private:
     std::vector<Edge<Weight>> edges_;
     std::vector<IncidenceList> incidence_lists_;
+    size_t removed_edge_count_ = 0;
 };
 
 template <typename Weight>
@@ -51,6 +65,47 @@ EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
     return id;
 }
 
+template <typename Weight>
+VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+    incidence_lists_.emplace_back();
+    return incidence_lists_.size() - 1;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::RemoveEdge(EdgeId edge_id) {
+    auto& incidence_list = incidence_lists_.at(edges_.at(edge_id).from);
+    const auto removed = std::remove(incidence_list.begin(), incidence_list.end(), edge_id);
+    removed_edge_count_ += incidence_list.end() - removed;
+    incidence_list.erase(removed, incidence_list.end());
+}
+
+template <typename Weight>
+std::vector<EdgeId> DirectedWeightedGraph<Weight>::Compact() {
+    // Живые рёбра — те, что остались в списках инцидентности
+    std::vector<EdgeId> new_ids(edges_.size(), NO_EDGE);
+    for (const auto& incidence_list : incidence_lists_) {
+        for (const EdgeId edge_id : incidence_list) {
+            new_ids[edge_id] = 0;
+        }
+    }
+    EdgeId next_id = 0;
+    for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+        if (new_ids[edge_id] != NO_EDGE) {
+            edges_[next_id] = edges_[edge_id];
+            new_ids[edge_id] = next_id++;
+        }
+    }
+    edges_.resize(next_id);
+    edges_.shrink_to_fit();
+    for (auto& incidence_list : incidence_lists_) {
+        for (EdgeId& edge_id : incidence_list) {
+            edge_id = new_ids[edge_id];
+        }
+    }
+    removed_edge_count_ = 0;
+    return new_ids;
+}
+
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
     return incidence_lists_.size();
@@ -61,6 +116,11 @@ size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
     return edges_.size();
 }
 
+template <typename Weight>
+size_t DirectedWeightedGraph<Weight>::GetRemovedEdgeCount() const {
+    return removed_edge_count_;
+}
+
 template <typename Weight>
 const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
     return edges_.at(edge_id);
@@ -0,0 +1,163 @@
+#include "id_set.h"
+//id_set.cpp
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+namespace id_set {
+namespace {
+
+constexpr uint32_t WORD_BITS = 64;
+// Массив занимает 32 бита на номер, маска — бит на каждый номер диапазона.
+// Обратно к массиву переходим с запасом, чтобы не переключаться на каждой вставке
+constexpr size_t DENSE_FROM = 32;
+constexpr size_t SPARSE_BELOW = 64;
+// Во сколько раз массивы должны различаться, чтобы вместо слияния искать
+// элементы меньшего двоичным поиском в большем
+constexpr size_t GALLOP_RATIO = 32;
+
+size_t WordCount(uint32_t universe) {
+    return (static_cast<size_t>(universe) + WORD_BITS - 1) / WORD_BITS;
+}
+
+}  // namespace
+
+IdSet::IdSet(std::vector<uint32_t> ids, uint32_t universe)
+    : size_(ids.size())
+    , universe_(universe)
+    , ids_(std::move(ids)) {
+    Rebalance();
+}
+
+void IdSet::MakeDense() {
+    words_.assign(WordCount(universe_), 0);
+    for (uint32_t id : ids_) {
+        words_[id / WORD_BITS] |= uint64_t{1} << (id % WORD_BITS);
+    }
+    std::vector<uint32_t>().swap(ids_);
+    dense_ = true;
+}
+
+void IdSet::MakeSparse() {
+    ids_ = ToVector();
+    std::vector<uint64_t>().swap(words_);
+    dense_ = false;
+}
+
+void IdSet::Rebalance() {
+    if (!dense_ && size_ * DENSE_FROM > universe_) {
+        MakeDense();
+    } else if (dense_ && size_ * SPARSE_BELOW < universe_) {
+        MakeSparse();
+    }
+}
+
+void IdSet::Insert(uint32_t id) {
+    if (id >= universe_) {
+        universe_ = id + 1;
+        if (dense_) {
+            words_.resize(WordCount(universe_), 0);
+        }
+    }
+    if (dense_) {
+        uint64_t& word = words_[id / WORD_BITS];
+        const uint64_t bit = uint64_t{1} << (id % WORD_BITS);
+        if (word & bit) {
+            return;
+        }
+        word |= bit;
+    } else {
+        auto it = std::lower_bound(ids_.begin(), ids_.end(), id);
+        if (it != ids_.end() && *it == id) {
+            return;
+        }
+        ids_.insert(it, id);
+    }
+    ++size_;
+    Rebalance();
+}
+
+void IdSet::Erase(uint32_t id) {
+    if (!Contains(id)) {
+        return;
+    }
+    if (dense_) {
+        words_[id / WORD_BITS] &= ~(uint64_t{1} << (id % WORD_BITS));
+    } else {
+        ids_.erase(std::lower_bound(ids_.begin(), ids_.end(), id));
+    }
+    --size_;
+    Rebalance();
+}
+
+bool IdSet::Contains(uint32_t id) const {
+    if (id >= universe_) {
+        return false;
+    }
+    if (dense_) {
+        return (words_[id / WORD_BITS] >> (id % WORD_BITS)) & 1;
+    }
+    return std::binary_search(ids_.begin(), ids_.end(), id);
+}
+
+IdSet IdSet::Intersect(const IdSet& other) const {
+    IdSet result;
+    result.universe_ = std::min(universe_, other.universe_);
+
+    if (dense_ && other.dense_) {
+        result.dense_ = true;
+        result.words_.resize(WordCount(result.universe_));
+        for (size_t i = 0; i < result.words_.size(); ++i) {
+            result.words_[i] = words_[i] & other.words_[i];
+            result.size_ += std::popcount(result.words_[i]);
+        }
+        result.Rebalance();
+        return result;
+    }
+
+    if (dense_ || other.dense_) {
+        const IdSet& sparse = dense_ ? other : *this;
+        const IdSet& dense = dense_ ? *this : other;
+        for (uint32_t id : sparse.ids_) {
+            if (dense.Contains(id)) {
+                result.ids_.push_back(id);
+            }
+        }
+    } else {
+        const auto& small = ids_.size() <= other.ids_.size() ? ids_ : other.ids_;
+        const auto& large = ids_.size() <= other.ids_.size() ? other.ids_ : ids_;
+        if (small.size() * GALLOP_RATIO < large.size()) {
+            auto from = large.begin();
+            for (uint32_t id : small) {
+                from = std::lower_bound(from, large.end(), id);
+                if (from == large.end()) {
+                    break;
+                }
+                if (*from == id) {
+                    result.ids_.push_back(id);
+                }
+            }
+        } else {
+            std::set_intersection(small.begin(), small.end(), large.begin(), large.end(),
+                                  std::back_inserter(result.ids_));
+        }
+    }
+    result.size_ = result.ids_.size();
+    return result;
+}
+
+std::vector<uint32_t> IdSet::ToVector() const {
+    if (!dense_) {
+        return ids_;
+    }
+    std::vector<uint32_t> ids;
+    ids.reserve(size_);
+    for (size_t i = 0; i < words_.size(); ++i) {
+        for (uint64_t word = words_[i]; word != 0; word &= word - 1) {
+            ids.push_back(static_cast<uint32_t>(i * WORD_BITS + std::countr_zero(word)));
+        }
+    }
+    return ids;
+}
+
+}  // namespace id_set
@@ -0,0 +1,49 @@
+#pragma once
+//id_set.h
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace id_set {
+
+// Множество небольших целых номеров (например, плотных номеров маршрутов).
+// Редкое множество хранится отсортированным массивом номеров, частое —
+// битовой маской над всем диапазоном; представление выбирается по тому,
+// что занимает меньше памяти. Пересечение двух масок — поразрядное AND
+// по 64-битным словам, маски и массива — проверка битов, двух массивов —
+// слияние (с двоичным поиском, если размеры сильно различаются)
+class IdSet {
+public:
+    IdSet() = default;
+    // ids — возрастающая последовательность без повторов, все номера меньше universe
+    IdSet(std::vector<uint32_t> ids, uint32_t universe);
+
+    void Insert(uint32_t id);
+    void Erase(uint32_t id);
+    bool Contains(uint32_t id) const;
+
+    size_t Size() const {
+        return size_;
+    }
+    bool Empty() const {
+        return size_ == 0;
+    }
+
+    IdSet Intersect(const IdSet& other) const;
+    // Номера по возрастанию
+    std::vector<uint32_t> ToVector() const;
+
+private:
+    // Переключает представление на более компактное
+    void Rebalance();
+    void MakeDense();
+    void MakeSparse();
+
+    bool dense_ = false;
+    size_t size_ = 0;
+    uint32_t universe_ = 0;
+    std::vector<uint32_t> ids_;
+    std::vector<uint64_t> words_;
+};
+
+}  // namespace id_set
@@ -1,6 +1,9 @@
 #include "json.h"
 //json.cpp
-#include <iterator>
+#include "json_scanner.h"
+
+#include <array>
+#include <charconv>
 
 namespace json {
 Node::Node(Node::Value value) : Node::Value(std::move(value)) {}
@@ -14,349 +17,584 @@ Node::Node(std::nullptr_t) : Value(nullptr) {}
 namespace {
 using namespace std::literals;
 
-Node LoadNode(std::istream& input);
-Node LoadString(std::istream& input);
+bool IsSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
 
+bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
 
-std::string LoadLiteral(std::istream& input) {
-    std::string s;
-    while (std::isalpha(input.peek())) {
-        s.push_back(static_cast<char>(input.get()));
-    }
-    return s;
+bool IsAlpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
 }
 
-Node LoadArray(std::istream& input) {
-    std::vector<Node> result;
+// Разбор из непрерывного буфера. Следующий символ грамматики и границы
+// участков строк берутся из индекса StructuralScanner, а не поиском по
+// байтам; строки копируются участками между спецсимволами, числа
+// преобразуются std::from_chars без промежуточной строки
+class Parser {
+public:
+    Parser(std::string_view text, Handler& handler)
+        : pos_(text.data())
+        , end_(text.data() + text.size())
+        , scanner_(text)
+        , handler_(handler) {
+    }
 
-    for (char c; input >> c && c != ']';) {
-        if (c != ',') {
-            input.putback(c);
+    void ParseNode() {
+        char c;
+        if (!NextChar(c)) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        switch (c) {
+            case '[':
+                if (handler_.SkipContainer()) {
+                    SkipContainer(pos_ - 1);
+                } else {
+                    ParseArray();
+                }
+                break;
+            case '{':
+                if (handler_.SkipContainer()) {
+                    SkipContainer(pos_ - 1);
+                } else {
+                    ParseDict();
+                }
+                break;
+            case '"':
+                handler_.Value(Node(ParseString()));
+                break;
+            case 't':
+                // Встретив t или f, переходим к попытке парсинга литералов true либо false
+                [[fallthrough]];
+            case 'f':
+                --pos_;
+                handler_.Value(ParseBool());
+                break;
+            case 'n':
+                --pos_;
+                handler_.Value(ParseNull());
+                break;
+            default:
+                --pos_;
+                handler_.Value(ParseNumber());
+                break;
         }
-        result.push_back(LoadNode(input));
-    }
-    if (!input) {
-        throw ParsingError("Array parsing error"s);
     }
-    return Node(std::move(result));
-}
 
-Node LoadDict(std::istream& input) {
-    Dict dict;
+private:
+    // Пропускает пробельные символы и читает следующий; false — конец входных данных
+    bool NextChar(char& c) {
+        const char* next = scanner_.Next(pos_);
+        if (pos_ != next && !IsSpace(*pos_)) {
+            // Число или литерал разобраны не до конца непробельной
+            // последовательности (например, «0123»): остаток читается
+            // посимвольно, как отдельное значение
+            c = *pos_++;
+            return true;
+        }
+        pos_ = next;
+        if (pos_ == end_) {
+            return false;
+        }
+        c = *pos_++;
+        return true;
+    }
 
-    for (char c; input >> c && c != '}';) {
-        if (c == '"') {
-            std::string key = LoadString(input).AsString();
-            if (input >> c && c == ':') {
-                if (dict.find(key) != dict.end()) {
-                    throw ParsingError("Duplicate key '"s + key + "' have been found");
+    // Находит по индексу конец массива или словаря, открытого в begin.
+    // Внутри строк отмечены только кавычки, \ и переводы строк, а
+    // экранированные кавычки не отмечены вовсе, так что строка кончается на
+    // первой отмеченной кавычке
+    void SkipContainer(const char* begin) {
+        size_t depth = 1;
+        bool in_string = false;
+        while (depth > 0) {
+            const char* mark = scanner_.Next(pos_);
+            if (mark == end_) {
+                if (in_string) {
+                    throw ParsingError("String parsing error"s);
                 }
-                dict.emplace(std::move(key), LoadNode(input));
-            } else {
-                throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                throw ParsingError(*begin == '[' ? "Array parsing error"s : "Dictionary parsing error"s);
+            }
+            pos_ = mark + 1;
+            if (in_string) {
+                in_string = *mark != '"';
+                continue;
+            }
+            switch (*mark) {
+                case '"':
+                    in_string = true;
+                    break;
+                case '[':
+                case '{':
+                    ++depth;
+                    break;
+                case ']':
+                case '}':
+                    --depth;
+                    break;
+                default:
+                    break;
             }
-        } else if (c != ',') {
-            throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
         }
+        handler_.RawValue({begin, static_cast<size_t>(pos_ - begin)});
     }
-    if (!input) {
-        throw ParsingError("Dictionary parsing error"s);
+
+    void ParseArray() {
+        handler_.StartArray();
+        char c;
+        bool closed = false;
+        while (NextChar(c)) {
+            if (c == ']') {
+                closed = true;
+                break;
+            }
+            if (c != ',') {
+                --pos_;
+            }
+            ParseNode();
+        }
+        if (!closed) {
+            throw ParsingError("Array parsing error"s);
+        }
+        handler_.EndArray();
     }
-    return Node(std::move(dict));
-}
 
-Node LoadString(std::istream& input) {
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
-    while (true) {
-        if (it == end) {
-            throw ParsingError("String parsing error");
+    void ParseDict() {
+        handler_.StartDict();
+        char c;
+        bool closed = false;
+        while (NextChar(c)) {
+            if (c == '}') {
+                closed = true;
+                break;
+            }
+            if (c == '"') {
+                std::string key = ParseString();
+                if (NextChar(c) && c == ':') {
+                    handler_.Key(std::move(key));
+                    ParseNode();
+                } else {
+                    throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                }
+            } else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
         }
-        const char ch = *it;
-        if (ch == '"') {
-            ++it;
-            break;
-        } else if (ch == '\\') {
-            ++it;
-            if (it == end) {
+        if (!closed) {
+            throw ParsingError("Dictionary parsing error"s);
+        }
+        handler_.EndDict();
+    }
+
+    std::string ParseString() {
+        std::string s;
+        while (true) {
+            // Обычные символы до следующей кавычки, \ или перевода строки
+            // копируются одним участком
+            const char* special = scanner_.Next(pos_);
+            s.append(pos_, special);
+            pos_ = special;
+            if (pos_ == end_) {
                 throw ParsingError("String parsing error");
             }
-            const char escaped_char = *(it);
-            switch (escaped_char) {
-                case 'n':
-                    s.push_back('\n');
-                    break;
-                case 't':
-                    s.push_back('\t');
-                    break;
-                case 'r':
-                    s.push_back('\r');
-                    break;
-                case '"':
-                    s.push_back('"');
-                    break;
-                case '\\':
-                    s.push_back('\\');
-                    break;
-                default:
-                    throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+            const char ch = *pos_++;
+            if (ch == '"') {
+                break;
+            } else if (ch == '\\') {
+                if (pos_ == end_) {
+                    throw ParsingError("String parsing error");
+                }
+                const char escaped_char = *pos_++;
+                switch (escaped_char) {
+                    case 'n':
+                        s.push_back('\n');
+                        break;
+                    case 't':
+                        s.push_back('\t');
+                        break;
+                    case 'r':
+                        s.push_back('\r');
+                        break;
+                    case '"':
+                        s.push_back('"');
+                        break;
+                    case '\\':
+                        s.push_back('\\');
+                        break;
+                    default:
+                        throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                }
+            } else if (ch == '\n' || ch == '\r') {
+                throw ParsingError("Unexpected end of line"s);
+            } else {
+                s.push_back(ch);
             }
-        } else if (ch == '\n' || ch == '\r') {
-            throw ParsingError("Unexpected end of line"s);
-        } else {
-            s.push_back(ch);
         }
-        ++it;
+        return s;
     }
 
-    return Node(std::move(s));
-}
+    std::string_view ParseLiteral() {
+        const char* begin = pos_;
+        while (pos_ != end_ && IsAlpha(*pos_)) {
+            ++pos_;
+        }
+        return {begin, static_cast<size_t>(pos_ - begin)};
+    }
 
-Node LoadBool(std::istream& input) {
-    const auto s = LoadLiteral(input);
-    if (s == "true"sv) {
-        return Node{true};
-    } else if (s == "false"sv) {
-        return Node{false};
-    } else {
-        throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+    Node ParseBool() {
+        const auto s = ParseLiteral();
+        if (s == "true"sv) {
+            return Node{true};
+        } else if (s == "false"sv) {
+            return Node{false};
+        } else {
+            throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
+        }
     }
-}
 
-Node LoadNull(std::istream& input) {
-    if (auto literal = LoadLiteral(input); literal == "null"sv) {
-        return Node{nullptr};
-    } else {
-        throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+    Node ParseNull() {
+        if (auto literal = ParseLiteral(); literal == "null"sv) {
+            return Node{nullptr};
+        } else {
+            throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
+        }
     }
-}
 
-Node LoadNumber(std::istream& input) {
-    std::string parsed_num;
+    Node ParseNumber() {
+        const char* begin = pos_;
 
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
-        }
-    };
+        // Пропускает одну или более цифр
+        auto skip_digits = [this] {
+            if (pos_ == end_ || !IsDigit(*pos_)) {
+                throw ParsingError("A digit is expected"s);
+            }
+            while (pos_ != end_ && IsDigit(*pos_)) {
+                ++pos_;
+            }
+        };
 
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
-            throw ParsingError("A digit is expected"s);
+        if (pos_ != end_ && *pos_ == '-') {
+            ++pos_;
         }
-        while (std::isdigit(input.peek())) {
-            read_char();
+        // Целая часть числа
+        if (pos_ != end_ && *pos_ == '0') {
+            ++pos_;
+            // После 0 в JSON не могут идти другие цифры
+        } else {
+            skip_digits();
         }
-    };
 
-    if (input.peek() == '-') {
-        read_char();
-    }
-    // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
-        // После 0 в JSON не могут идти другие цифры
-    } else {
-        read_digits();
-    }
-
-    bool is_int = true;
-    // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
-        read_digits();
-        is_int = false;
-    }
+        bool is_int = true;
+        // Дробная часть числа
+        if (pos_ != end_ && *pos_ == '.') {
+            ++pos_;
+            skip_digits();
+            is_int = false;
+        }
 
-    // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+        // Экспоненциальная часть числа
+        if (pos_ != end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+            ++pos_;
+            if (pos_ != end_ && (*pos_ == '+' || *pos_ == '-')) {
+                ++pos_;
+            }
+            skip_digits();
+            is_int = false;
         }
-        read_digits();
-        is_int = false;
-    }
 
-    try {
         if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-                // В случае неудачи, например, при переполнении
-                // код ниже попробует преобразовать строку в double
+            // Сначала пробуем int; при переполнении число читается как double
+            int value;
+            if (auto [ptr, ec] = std::from_chars(begin, pos_, value); ec == std::errc{} && ptr == pos_) {
+                return Node(value);
             }
         }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+        double value;
+        if (auto [ptr, ec] = std::from_chars(begin, pos_, value); ec == std::errc{} && ptr == pos_) {
+            return Node(value);
+        }
+        throw ParsingError("Failed to convert "s + std::string(begin, pos_) + " to number"s);
     }
+
+    const char* pos_;
+    const char* end_;
+    StructuralScanner scanner_;
+    Handler& handler_;
+};
+
+// Сколько текста Writer копит перед записью в поток
+constexpr size_t WRITE_BUFFER_SIZE = 64 * 1024;
+constexpr int INDENT_STEP = 4;
+
+// Что выводится после \ вместо символа строки; 0 — символ выводится как есть
+constexpr std::array<char, 256> ESCAPES = [] {
+    std::array<char, 256> escapes{};
+    escapes['\r'] = 'r';
+    escapes['\n'] = 'n';
+    escapes['\t'] = 't';
+    escapes['"'] = '"';
+    escapes['\\'] = '\\';
+    return escapes;
+}();
+
+}  // namespace
+
+void TreeBuilder::StartDict() {
+    stack_.emplace_back(Dict{});
+}
+
+void TreeBuilder::EndDict() {
+    Node dict = std::move(stack_.back());
+    stack_.pop_back();
+    Add(std::move(dict));
+}
+
+void TreeBuilder::StartArray() {
+    stack_.emplace_back(Array{});
+}
+
+void TreeBuilder::EndArray() {
+    Node array = std::move(stack_.back());
+    stack_.pop_back();
+    Add(std::move(array));
+}
+
+void TreeBuilder::Key(std::string key) {
+    keys_.push_back(std::move(key));
+}
+
+void TreeBuilder::Value(Node value) {
+    Add(std::move(value));
 }
 
-Node LoadNode(std::istream& input) {
-    char c;
-    if (!(input >> c)) {
-        throw ParsingError("Unexpected EOF"s);
+Node TreeBuilder::Extract() {
+    Node root = std::move(*root_);
+    root_.reset();
+    return root;
+}
+
+void TreeBuilder::Add(Node node) {
+    if (stack_.empty()) {
+        root_ = std::move(node);
+        return;
+    }
+    auto& container = stack_.back().GetValue();
+    if (auto* array = std::get_if<Array>(&container)) {
+        array->push_back(std::move(node));
+        return;
     }
-    switch (c) {
-        case '[':
-            return LoadArray(input);
-        case '{':
-            return LoadDict(input);
-        case '"':
-            return LoadString(input);
-        case 't':
-            // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
-            // подсказкой компилятору и человеку, что здесь программист явно задумывал
-            // разрешить переход к инструкции следующей ветки case, а не случайно забыл
-            // написать break, return или throw.
-            // В данном случае, встретив t или f, переходим к попытке парсинга
-            // литералов true либо false
-            [[fallthrough]];
-        case 'f':
-            input.putback(c);
-            return LoadBool(input);
-        case 'n':
-            input.putback(c);
-            return LoadNull(input);
-        default:
-            input.putback(c);
-            return LoadNumber(input);
+    auto& dict = std::get<Dict>(container);
+    std::string key = std::move(keys_.back());
+    keys_.pop_back();
+    if (dict.find(key) != dict.end()) {
+        throw ParsingError("Duplicate key '"s + key + "' have been found");
     }
+    dict.emplace(std::move(key), std::move(node));
 }
 
-struct PrintContext {
-    std::ostream& out;
-    int indent_step = 4;
-    int indent = 0;
+void Parse(std::string_view text, Handler& handler) {
+    Parser(text, handler).ParseNode();
+}
 
-    void PrintIndent() const {
-        for (int i = 0; i < indent; ++i) {
-            out.put(' ');
-        }
-    }
+void Parse(std::istream& input, Handler& handler) {
+    Parse(ReadAll(input), handler);
+}
 
-    PrintContext Indented() const {
-        return {out, indent_step, indent_step + indent};
+Document Load(std::string_view text) {
+    TreeBuilder builder;
+    Parse(text, builder);
+    return Document{builder.Extract()};
+}
+
+Document Load(std::istream& input) {
+    return Load(ReadAll(input));
+}
+
+std::string ReadAll(std::istream& input) {
+    std::string text;
+    char buffer[1 << 16];
+    while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0) {
+        text.append(buffer, input.gcount());
     }
-};
+    return text;
+}
 
-void PrintNode(const Node& value, const PrintContext& ctx);
+Writer::Writer(std::ostream& output, PrintOptions options)
+    : output_(output)
+    , options_(options) {
+    buffer_.reserve(WRITE_BUFFER_SIZE);
+}
 
-template <typename Value>
-void PrintValue(const Value& value, const PrintContext& ctx) {
-    ctx.out << value;
+Writer::~Writer() {
+    Flush();
 }
 
-void PrintString(const std::string& value, std::ostream& out) {
-    out.put('"');
-    for (const char c : value) {
-        switch (c) {
-            case '\r':
-                out << "\\r"sv;
-                break;
-            case '\n':
-                out << "\\n"sv;
-                break;
-            case '\t':
-                out << "\\t"sv;
-                break;
-            case '"':
-                // Символы " и \ выводятся как \" или \\, соответственно
-                [[fallthrough]];
-            case '\\':
-                out.put('\\');
-                [[fallthrough]];
-            default:
-                out.put(c);
-                break;
-        }
+Writer& Writer::StartDict() {
+    BeforeValue();
+    buffer_.push_back('{');
+    empty_.push_back(true);
+    return *this;
+}
+
+Writer& Writer::EndDict() {
+    Close('}');
+    return *this;
+}
+
+Writer& Writer::StartArray() {
+    BeforeValue();
+    buffer_.push_back('[');
+    empty_.push_back(true);
+    return *this;
+}
+
+Writer& Writer::EndArray() {
+    Close(']');
+    return *this;
+}
+
+Writer& Writer::Key(std::string_view key) {
+    Separate();
+    WriteString(key);
+    buffer_.push_back(':');
+    if (!options_.compact) {
+        buffer_.push_back(' ');
     }
-    out.put('"');
+    after_key_ = true;
+    return *this;
 }
 
-template <>
-void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
-    PrintString(value, ctx.out);
+Writer& Writer::Value(std::nullptr_t) {
+    BeforeValue();
+    buffer_.append("null"sv);
+    FlushIfFull();
+    return *this;
 }
 
-template <>
-void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
-    ctx.out << "null"sv;
+Writer& Writer::Value(bool value) {
+    BeforeValue();
+    buffer_.append(value ? "true"sv : "false"sv);
+    FlushIfFull();
+    return *this;
 }
 
-// В специализации шаблона PrintValue для типа bool параметр value передаётся
-// по константной ссылке, как и в основном шаблоне.
-// В качестве альтернативы можно использовать перегрузку:
-// void PrintValue(bool value, const PrintContext& ctx);
-template <>
-void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
-    ctx.out << (value ? "true"sv : "false"sv);
+Writer& Writer::Value(int value) {
+    BeforeValue();
+    char chars[16];
+    const auto result = std::to_chars(chars, chars + sizeof(chars), value);
+    buffer_.append(chars, result.ptr);
+    FlushIfFull();
+    return *this;
 }
 
-template <>
-void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
-    std::ostream& out = ctx.out;
-    out << "[\n"sv;
-    bool first = true;
-    auto inner_ctx = ctx.Indented();
-    for (const Node& node : nodes) {
-        if (first) {
-            first = false;
+Writer& Writer::Value(double value) {
+    BeforeValue();
+    char chars[32];
+    const auto result = options_.round_trip_doubles
+        ? std::to_chars(chars, chars + sizeof(chars), value)
+        : std::to_chars(chars, chars + sizeof(chars), value, std::chars_format::general, 6);
+    buffer_.append(chars, result.ptr);
+    FlushIfFull();
+    return *this;
+}
+
+Writer& Writer::Value(std::string_view value) {
+    BeforeValue();
+    WriteString(value);
+    FlushIfFull();
+    return *this;
+}
+
+Writer& Writer::Value(const Node& node) {
+    std::visit([this](const auto& value) {
+        using T = std::decay_t<decltype(value)>;
+        if constexpr (std::is_same_v<T, Array>) {
+            StartArray();
+            for (const Node& item : value) {
+                Value(item);
+            }
+            EndArray();
+        } else if constexpr (std::is_same_v<T, Dict>) {
+            StartDict();
+            for (const auto& [key, item] : value) {
+                Key(key);
+                Value(item);
+            }
+            EndDict();
         } else {
-            out << ",\n"sv;
+            Value(value);
         }
-        inner_ctx.PrintIndent();
-        PrintNode(node, inner_ctx);
+    }, node.GetValue());
+    return *this;
+}
+
+void Writer::Flush() {
+    output_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+}
+
+void Writer::Separate() {
+    if (!empty_.back()) {
+        buffer_.push_back(',');
     }
-    out.put('\n');
-    ctx.PrintIndent();
-    out.put(']');
-}
-
-template <>
-void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
-    std::ostream& out = ctx.out;
-    out << "{\n"sv;
-    bool first = true;
-    auto inner_ctx = ctx.Indented();
-    for (const auto& [key, node] : nodes) {
-        if (first) {
-            first = false;
-        } else {
-            out << ",\n"sv;
-        }
-        inner_ctx.PrintIndent();
-        PrintString(key, ctx.out);
-        out << ": "sv;
-        PrintNode(node, inner_ctx);
+    empty_.back() = false;
+    if (!options_.compact) {
+        buffer_.push_back('\n');
+        Indent(empty_.size());
     }
-    out.put('\n');
-    ctx.PrintIndent();
-    out.put('}');
 }
 
-void PrintNode(const Node& node, const PrintContext& ctx) {
-    std::visit(
-        [&ctx](const auto& value) {
-            PrintValue(value, ctx);
-        },
-        node.GetValue());
+void Writer::BeforeValue() {
+    if (after_key_) {
+        after_key_ = false;
+    } else if (!empty_.empty()) {
+        Separate();
+    }
 }
 
-}  // namespace
+void Writer::Close(char bracket) {
+    const bool was_empty = empty_.back();
+    empty_.pop_back();
+    if (!options_.compact) {
+        // Print выводит пустой массив или словарь как «[», две пустые строки и «]»
+        buffer_.append(was_empty ? "\n\n"sv : "\n"sv);
+        Indent(empty_.size());
+    }
+    buffer_.push_back(bracket);
+    FlushIfFull();
+}
 
-Document Load(std::istream& input) {
-    return Document{LoadNode(input)};
+void Writer::Indent(size_t depth) {
+    buffer_.append(depth * INDENT_STEP, ' ');
+}
+
+void Writer::WriteString(std::string_view value) {
+    buffer_.push_back('"');
+    const char* run = value.data();
+    const char* const end = value.data() + value.size();
+    for (const char* it = run; it != end; ++it) {
+        const char escape = ESCAPES[static_cast<unsigned char>(*it)];
+        if (escape != 0) {
+            buffer_.append(run, it);
+            buffer_.push_back('\\');
+            buffer_.push_back(escape);
+            run = it + 1;
+        }
+    }
+    buffer_.append(run, end);
+    buffer_.push_back('"');
+}
+
+void Writer::FlushIfFull() {
+    if (buffer_.size() >= WRITE_BUFFER_SIZE) {
+        Flush();
+    }
 }
 
-void Print(const Document& doc, std::ostream& output) {
-    PrintNode(doc.GetRoot(), PrintContext{output});
+void Print(const Document& doc, std::ostream& output, const PrintOptions& options) {
+    Writer(output, options).Value(doc.GetRoot());
 }
 
 }  // namespace json
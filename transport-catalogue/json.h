@@ -2,7 +2,9 @@
 //json.h
 #include <iostream>
 #include <map>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -147,8 +149,131 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
     return !(lhs == rhs);
 }
 
+// Получатель событий потокового разбора (см. Parse). Ключ словаря приходит
+// через Key перед своим значением, null, bool, числа и строки — через Value
+class Handler {
+public:
+    virtual void StartDict() = 0;
+    virtual void EndDict() = 0;
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+    virtual void Key(std::string key) = 0;
+    virtual void Value(Node value) = 0;
+
+    // Спрашивается перед каждым массивом и словарём. Если вернуть true,
+    // содержимое не разбирается и не проверяется: парсер только находит
+    // парную закрывающую скобку и передаёт весь текст значения в RawValue
+    virtual bool SkipContainer() {
+        return false;
+    }
+    virtual void RawValue(std::string_view /*text*/) {
+    }
+
+protected:
+    ~Handler() = default;
+};
+
+// Собирает из событий дерево Node. Может собирать значения по очереди:
+// после того как значение собрано, его забирают через Extract
+class TreeBuilder final : public Handler {
+public:
+    void StartDict() override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+    void Key(std::string key) override;
+    void Value(Node value) override;
+
+    // Собрано ли значение целиком
+    bool IsComplete() const {
+        return root_.has_value();
+    }
+    Node Extract();
+
+private:
+    void Add(Node node);
+
+    // Незакрытые массивы и словари, в конце — самый вложенный
+    std::vector<Node> stack_;
+    // Ключи, ждущие значения, по одному на незакрытый словарь
+    std::vector<std::string> keys_;
+    std::optional<Node> root_;
+};
+
+// Разбирает одно значение JSON, не строя дерева: о каждом элементе
+// сообщается handler в порядке следования во входных данных.
+// Разбор идёт по непрерывному буферу; перегрузка для потока сначала
+// читает его целиком
+void Parse(std::string_view text, Handler& handler);
+void Parse(std::istream& input, Handler& handler);
+
+Document Load(std::string_view text);
 Document Load(std::istream& input);
 
-void Print(const Document& doc, std::ostream& output);
+// Всё содержимое потока до конца
+std::string ReadAll(std::istream& input);
+
+struct PrintOptions {
+    // Без переводов строк и отступов
+    bool compact = false;
+    // Кратчайшая запись double, которая читается обратно в то же число.
+    // По умолчанию — 6 значащих цифр, как при выводе в std::ostream
+    bool round_trip_doubles = false;
+};
+
+// Пишет JSON по событиям, как Builder, но без построения Node: значения
+// сразу форматируются в буфер, который уходит в поток большими блоками.
+// Числа форматируются std::to_chars, без локали потока; в строках участки
+// без спецсимволов копируются целиком. Разметка та же, что у Print
+class Writer {
+public:
+    explicit Writer(std::ostream& output, PrintOptions options = {});
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+    // Сбрасывает буфер в поток
+    ~Writer();
+
+    Writer& StartDict();
+    Writer& EndDict();
+    Writer& StartArray();
+    Writer& EndArray();
+    Writer& Key(std::string_view key);
+    Writer& Value(std::nullptr_t);
+    Writer& Value(bool value);
+    Writer& Value(int value);
+    Writer& Value(double value);
+    Writer& Value(std::string_view value);
+    // Иначе строковый литерал выбрал бы перегрузку для bool, а std::string
+    // неоднозначно преобразуется и в string_view, и в Node
+    Writer& Value(const char* value) {
+        return Value(std::string_view(value));
+    }
+    Writer& Value(const std::string& value) {
+        return Value(std::string_view(value));
+    }
+    Writer& Value(const Node& node);
+
+    // Отдаёт накопленный текст в поток
+    void Flush();
+
+private:
+    // Запятая и отступ перед элементом массива или ключом
+    void Separate();
+    void BeforeValue();
+    void Close(char bracket);
+    void Indent(size_t depth);
+    void WriteString(std::string_view value);
+    void FlushIfFull();
+
+    std::ostream& output_;
+    PrintOptions options_;
+    std::string buffer_;
+    // По одному на незакрытый массив или словарь: в нём ещё нет элементов
+    std::vector<bool> empty_;
+    // Ключ выведен, ждём его значение
+    bool after_key_ = false;
+};
+
+void Print(const Document& doc, std::ostream& output, const PrintOptions& options = {});
 
 }  // namespace json
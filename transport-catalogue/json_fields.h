@@ -0,0 +1,94 @@
+#pragma once
+//json_fields.h
+#include "json.h"
+
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace json {
+
+// Поле объекта: ключ и способ получить значение — указатель на член или
+// функция от объекта
+template <typename Get>
+struct Field {
+    std::string_view key;
+    Get get;
+};
+
+template <typename Get>
+Field(std::string_view, Get) -> Field<Get>;
+
+// Описание типа, который пишется словарём: специализация объявляет
+//   static constexpr std::tuple FIELDS{Field{...}, ...};
+// Поля перечисляются по возрастанию ключей — в том порядке, в каком Print
+// выводит Dict, поэтому текст совпадает с напечатанным деревом.
+// Поле со значением std::nullopt не выводится
+template <typename T>
+struct ObjectFields;
+
+template <typename T>
+concept DescribedObject = requires {
+    ObjectFields<T>::FIELDS;
+};
+
+template <typename Fields>
+constexpr bool KeysAscending(const Fields& fields) {
+    return std::apply([](const auto&... field) {
+        std::string_view previous;
+        bool first = true;
+        bool ascending = true;
+        ((ascending = ascending && (first || previous < field.key), previous = field.key, first = false), ...);
+        return ascending;
+    }, fields);
+}
+
+template <typename T>
+void Write(Writer& writer, const T& value);
+
+template <typename T>
+struct IsOptional : std::false_type {};
+
+template <typename T>
+struct IsOptional<std::optional<T>> : std::true_type {};
+
+template <typename T>
+void WriteField(Writer& writer, std::string_view key, const T& value) {
+    if constexpr (IsOptional<T>::value) {
+        if (value) {
+            WriteField(writer, key, *value);
+        }
+    } else {
+        writer.Key(key);
+        Write(writer, value);
+    }
+}
+
+// Пишет значение без построения Node: описанные типы — словарями,
+// строки — строками, прочие диапазоны — массивами, числа и bool — как есть
+template <typename T>
+void Write(Writer& writer, const T& value) {
+    if constexpr (DescribedObject<T>) {
+        static_assert(KeysAscending(ObjectFields<T>::FIELDS), "fields must be listed in ascending key order");
+        writer.StartDict();
+        std::apply([&writer, &value](const auto&... field) {
+            (WriteField(writer, field.key, std::invoke(field.get, value)), ...);
+        }, ObjectFields<T>::FIELDS);
+        writer.EndDict();
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        writer.Value(std::string_view(value));
+    } else if constexpr (std::ranges::range<const T>) {
+        writer.StartArray();
+        for (const auto& item : value) {
+            Write(writer, item);
+        }
+        writer.EndArray();
+    } else {
+        writer.Value(value);
+    }
+}
+
+}  // namespace json
@@ -0,0 +1,274 @@
+#include "json_flat.h"
+//json_flat.cpp
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace json {
+
+using namespace std::literals;
+
+namespace {
+
+// Словари до такого размера просматриваются подряд, большие — двоичным поиском
+constexpr size_t LINEAR_SEARCH_LIMIT = 8;
+
+bool KeyLess(const FlatMember& lhs, const FlatMember& rhs) {
+    return lhs.key < rhs.key;
+}
+
+}  // namespace
+
+bool FlatNode::AsBool() const {
+    if (!IsBool()) {
+        throw std::logic_error("Not a bool"s);
+    }
+    return bool_;
+}
+
+int FlatNode::AsInt() const {
+    if (!IsInt()) {
+        throw std::logic_error("Not an int"s);
+    }
+    return int_;
+}
+
+double FlatNode::AsDouble() const {
+    if (!IsDouble()) {
+        throw std::logic_error("Not a double"s);
+    }
+    return IsPureDouble() ? double_ : int_;
+}
+
+std::string_view FlatNode::AsString() const {
+    if (!IsString()) {
+        throw std::logic_error("Not a string"s);
+    }
+    return {chars_, size_};
+}
+
+std::span<const FlatNode> FlatNode::AsArray() const {
+    if (!IsArray()) {
+        throw std::logic_error("Not an array"s);
+    }
+    return {items_, size_};
+}
+
+std::span<const FlatMember> FlatNode::AsDict() const {
+    if (!IsDict()) {
+        throw std::logic_error("Not a dict"s);
+    }
+    return {members_, size_};
+}
+
+const FlatNode* FlatNode::Find(std::string_view key) const {
+    const auto members = AsDict();
+    if (members.size() <= LINEAR_SEARCH_LIMIT) {
+        for (const FlatMember& member : members) {
+            if (member.key == key) {
+                return &member.value;
+            }
+        }
+        return nullptr;
+    }
+    auto it = std::lower_bound(members.begin(), members.end(), key,
+                               [](const FlatMember& member, std::string_view value) { return member.key < value; });
+    return it != members.end() && it->key == key ? &it->value : nullptr;
+}
+
+Node FlatNode::ToNode() const {
+    switch (type_) {
+        case Type::NUL:
+            return Node{nullptr};
+        case Type::BOOL:
+            return Node{bool_};
+        case Type::INT:
+            return Node{int_};
+        case Type::DOUBLE:
+            return Node{double_};
+        case Type::STRING:
+            return Node{std::string(chars_, size_)};
+        case Type::ARRAY: {
+            Array array;
+            array.reserve(size_);
+            for (const FlatNode& item : AsArray()) {
+                array.push_back(item.ToNode());
+            }
+            return Node{std::move(array)};
+        }
+        case Type::DICT: {
+            Dict dict;
+            for (const FlatMember& member : AsDict()) {
+                dict.emplace_hint(dict.end(), std::string(member.key), member.value.ToNode());
+            }
+            return Node{std::move(dict)};
+        }
+    }
+    return {};
+}
+
+FlatDocument::FlatDocument()
+    : arena_(std::make_unique<std::pmr::monotonic_buffer_resource>()) {
+}
+
+std::string_view FlatDocument::InternKey(std::string_view key) {
+    std::string_view& recent = recent_keys_[std::hash<std::string_view>{}(key) % RECENT_KEYS];
+    if (recent != key) {
+        recent = CopyString(key);
+    }
+    return recent;
+}
+
+std::string_view FlatDocument::CopyString(std::string_view str) {
+    if (str.empty()) {
+        return {};
+    }
+    char* data = static_cast<char*>(arena_->allocate(str.size(), alignof(char)));
+    std::memcpy(data, str.data(), str.size());
+    return {data, str.size()};
+}
+
+void FlatBuilder::StartDict() {
+    frames_.push_back({true, items_.size()});
+}
+
+void FlatBuilder::EndDict() {
+    const size_t first = frames_.back().first_item;
+    frames_.pop_back();
+    const auto begin = items_.begin() + first;
+    std::sort(begin, items_.end(), KeyLess);
+    auto duplicate = std::adjacent_find(begin, items_.end(), [](const FlatMember& lhs, const FlatMember& rhs) {
+        return lhs.key == rhs.key;
+    });
+    if (duplicate != items_.end()) {
+        throw ParsingError("Duplicate key '"s + std::string(duplicate->key) + "' have been found");
+    }
+
+    FlatNode dict;
+    dict.type_ = FlatNode::Type::DICT;
+    dict.size_ = static_cast<uint32_t>(items_.size() - first);
+    FlatMember* members = Allocate<FlatMember>(dict.size_);
+    std::uninitialized_copy(begin, items_.end(), members);
+    dict.members_ = members;
+    items_.erase(begin, items_.end());
+    Add(dict);
+}
+
+void FlatBuilder::StartArray() {
+    frames_.push_back({false, items_.size()});
+}
+
+void FlatBuilder::EndArray() {
+    const size_t first = frames_.back().first_item;
+    frames_.pop_back();
+
+    FlatNode array;
+    array.type_ = FlatNode::Type::ARRAY;
+    array.size_ = static_cast<uint32_t>(items_.size() - first);
+    FlatNode* items = Allocate<FlatNode>(array.size_);
+    for (size_t i = 0; i < array.size_; ++i) {
+        std::construct_at(items + i, items_[first + i].value);
+    }
+    array.items_ = items;
+    items_.erase(items_.begin() + first, items_.end());
+    Add(array);
+}
+
+void FlatBuilder::Key(std::string key) {
+    keys_.push_back(document_.InternKey(key));
+}
+
+void FlatBuilder::Value(Node value) {
+    FlatNode node;
+    std::visit([this, &node](const auto& v) {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, bool>) {
+            node.type_ = FlatNode::Type::BOOL;
+            node.bool_ = v;
+        } else if constexpr (std::is_same_v<T, int>) {
+            node.type_ = FlatNode::Type::INT;
+            node.int_ = v;
+        } else if constexpr (std::is_same_v<T, double>) {
+            node.type_ = FlatNode::Type::DOUBLE;
+            node.double_ = v;
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            const std::string_view str = document_.CopyString(v);
+            node.type_ = FlatNode::Type::STRING;
+            node.size_ = static_cast<uint32_t>(str.size());
+            node.chars_ = str.data();
+        } else if constexpr (std::is_same_v<T, Array>) {
+            // Готовые контейнеры разбор не присылает, но обработчик их принимает
+            StartArray();
+            for (const Node& item : v) {
+                Value(item);
+            }
+            EndArray();
+            return;
+        } else if constexpr (std::is_same_v<T, Dict>) {
+            StartDict();
+            for (const auto& [key, item] : v) {
+                Key(key);
+                Value(item);
+            }
+            EndDict();
+            return;
+        }
+        Add(node);
+    }, value.GetValue());
+}
+
+FlatNode FlatBuilder::ExtractRoot() {
+    if (!complete_) {
+        throw std::logic_error("Value is not complete"s);
+    }
+    complete_ = false;
+    return document_.root_;
+}
+
+void FlatBuilder::Reset() {
+    complete_ = false;
+    frames_.clear();
+    items_.clear();
+    keys_.clear();
+}
+
+FlatDocument FlatBuilder::Extract() {
+    complete_ = false;
+    return std::exchange(document_, FlatDocument{});
+}
+
+void FlatBuilder::Add(FlatNode node) {
+    if (frames_.empty()) {
+        document_.root_ = node;
+        complete_ = true;
+        return;
+    }
+    std::string_view key;
+    if (frames_.back().is_dict) {
+        key = keys_.back();
+        keys_.pop_back();
+    }
+    items_.push_back({key, node});
+}
+
+template <typename T>
+T* FlatBuilder::Allocate(size_t count) {
+    if (count == 0) {
+        return nullptr;
+    }
+    return static_cast<T*>(document_.arena_->allocate(count * sizeof(T), alignof(T)));
+}
+
+FlatDocument LoadFlat(std::string_view text) {
+    FlatBuilder builder;
+    Parse(text, builder);
+    return builder.Extract();
+}
+
+FlatDocument LoadFlat(std::istream& input) {
+    return LoadFlat(ReadAll(input));
+}
+
+}  // namespace json
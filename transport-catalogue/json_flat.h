@@ -0,0 +1,170 @@
+#pragma once
+//json_flat.h
+#include "json.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+struct FlatMember;
+
+// Узел плоского дерева. Узлы, строки и массивы элементов лежат в арене
+// FlatDocument и живут, пока жив документ. Словарь — массив FlatMember,
+// упорядоченный по ключу, как Dict
+class FlatNode {
+public:
+    FlatNode() = default;
+
+    bool IsNull() const {
+        return type_ == Type::NUL;
+    }
+    bool IsBool() const {
+        return type_ == Type::BOOL;
+    }
+    bool IsInt() const {
+        return type_ == Type::INT;
+    }
+    bool IsPureDouble() const {
+        return type_ == Type::DOUBLE;
+    }
+    bool IsDouble() const {
+        return IsInt() || IsPureDouble();
+    }
+    bool IsString() const {
+        return type_ == Type::STRING;
+    }
+    bool IsArray() const {
+        return type_ == Type::ARRAY;
+    }
+    bool IsDict() const {
+        return type_ == Type::DICT;
+    }
+
+    bool AsBool() const;
+    int AsInt() const;
+    double AsDouble() const;
+    std::string_view AsString() const;
+    std::span<const FlatNode> AsArray() const;
+    std::span<const FlatMember> AsDict() const;
+
+    // Значение по ключу или nullptr, если ключа нет; узел должен быть словарём
+    const FlatNode* Find(std::string_view key) const;
+
+    // Копия поддерева в обычном дереве Node
+    Node ToNode() const;
+
+private:
+    friend class FlatBuilder;
+
+    enum class Type : uint8_t {
+        NUL,
+        BOOL,
+        INT,
+        DOUBLE,
+        STRING,
+        ARRAY,
+        DICT,
+    };
+
+    Type type_ = Type::NUL;
+    // Длина строки или число элементов массива и словаря
+    uint32_t size_ = 0;
+    union {
+        bool bool_;
+        int int_;
+        double double_;
+        const char* chars_;
+        const FlatNode* items_;
+        const FlatMember* members_ = nullptr;
+    };
+};
+
+// Элемент словаря; ключ лежит в арене документа
+struct FlatMember {
+    std::string_view key;
+    FlatNode value;
+};
+
+// Плоский документ: все узлы, строки и ключи — в одной арене, которая
+// освобождается целиком вместе с документом. Повторяющиеся ключи вроде
+// "type" и "name" хранятся один раз: недавние ключи помнит небольшая
+// таблица, так что ключи-данные (названия остановок в road_distances) её
+// не раздувают
+class FlatDocument {
+public:
+    FlatDocument();
+
+    const FlatNode& GetRoot() const {
+        return root_;
+    }
+
+private:
+    friend class FlatBuilder;
+
+    static constexpr size_t RECENT_KEYS = 256;
+
+    std::string_view InternKey(std::string_view key);
+    std::string_view CopyString(std::string_view str);
+
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+    // Последний ключ с таким остатком хеша
+    std::array<std::string_view, RECENT_KEYS> recent_keys_{};
+    FlatNode root_;
+};
+
+// Собирает FlatDocument из событий разбора (см. json::Parse). Как и
+// TreeBuilder, может собирать значения по очереди: корень собранного
+// значения забирают через ExtractRoot, а его узлы остаются в арене
+// документа, так что много мелких значений делят одну арену и одну
+// таблицу ключей
+class FlatBuilder final : public Handler {
+public:
+    void StartDict() override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+    void Key(std::string key) override;
+    void Value(Node value) override;
+
+    // Собрано ли значение целиком
+    bool IsComplete() const {
+        return complete_;
+    }
+    // Корень собранного значения; действителен, пока жив документ,
+    // отданный Extract
+    FlatNode ExtractRoot();
+    // Отбрасывает недособранное значение, например после ошибки разбора.
+    // Уже занятая им память арены освободится вместе с документом
+    void Reset();
+
+    FlatDocument Extract();
+
+private:
+    // Незакрытый массив или словарь: его элементы — в конце items_
+    struct Frame {
+        bool is_dict;
+        size_t first_item;
+    };
+
+    void Add(FlatNode node);
+    template <typename T>
+    T* Allocate(size_t count);
+
+    FlatDocument document_;
+    bool complete_ = false;
+    std::vector<Frame> frames_;
+    // Элементы незакрытых контейнеров; у элементов массивов ключ пуст
+    std::vector<FlatMember> items_;
+    std::vector<std::string_view> keys_;
+};
+
+FlatDocument LoadFlat(std::string_view text);
+FlatDocument LoadFlat(std::istream& input);
+
+}  // namespace json
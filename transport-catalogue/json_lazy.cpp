@@ -0,0 +1,143 @@
+#include "json_lazy.h"
+//json_lazy.cpp
+#include <optional>
+
+namespace json {
+
+using namespace std::literals;
+
+namespace {
+
+// Собирает один уровень: массивы и словари глубже skip_depth не
+// разбираются и становятся неразобранными узлами
+class LevelBuilder final : public Handler {
+public:
+    explicit LevelBuilder(size_t skip_depth)
+        : skip_depth_(skip_depth) {
+    }
+
+    void StartDict() override {
+        ++depth_;
+    }
+    void EndDict() override {
+        --depth_;
+    }
+    void StartArray() override {
+        ++depth_;
+    }
+    void EndArray() override {
+        --depth_;
+    }
+    void Key(std::string key) override {
+        key_ = std::move(key);
+    }
+    void Value(Node value) override {
+        Add(LazyNode(std::move(value)));
+    }
+    bool SkipContainer() override {
+        return depth_ >= skip_depth_;
+    }
+    void RawValue(std::string_view text) override {
+        Add(LazyNode::FromText(text));
+    }
+
+    LazyNode ExtractRoot() {
+        return std::move(*root_);
+    }
+    LazyArray ExtractArray() {
+        return std::move(array_);
+    }
+    LazyDict ExtractDict() {
+        return std::move(dict_);
+    }
+
+private:
+    void Add(LazyNode node) {
+        if (depth_ == 0) {
+            root_.emplace(std::move(node));
+        } else if (key_) {
+            if (dict_.count(*key_) > 0) {
+                throw ParsingError("Duplicate key '"s + *key_ + "' have been found");
+            }
+            dict_.emplace(std::move(*key_), std::move(node));
+            key_.reset();
+        } else {
+            array_.push_back(std::move(node));
+        }
+    }
+
+    size_t skip_depth_;
+    size_t depth_ = 0;
+    std::optional<std::string> key_;
+    std::optional<LazyNode> root_;
+    LazyArray array_;
+    LazyDict dict_;
+};
+
+LazyNode ParseRoot(std::string_view text) {
+    LevelBuilder builder(0);
+    Parse(text, builder);
+    return builder.ExtractRoot();
+}
+
+}  // namespace
+
+LazyNode::LazyNode(Node value) {
+    // Присваивание вместо инициализации: с ней GCC 12 ложно предупреждает
+    // о неинициализированном variant при встраивании
+    value_ = std::move(value);
+}
+
+LazyNode LazyNode::FromText(std::string_view text) {
+    LazyNode node;
+    node.text_ = text;
+    return node;
+}
+
+const LazyArray& LazyNode::AsArray() const {
+    if (!IsArray()) {
+        throw std::logic_error("Not an array"s);
+    }
+    if (!array_) {
+        LevelBuilder builder(1);
+        Parse(text_, builder);
+        array_ = std::make_unique<LazyArray>(builder.ExtractArray());
+    }
+    return *array_;
+}
+
+const LazyDict& LazyNode::AsDict() const {
+    if (!IsDict()) {
+        throw std::logic_error("Not a dict"s);
+    }
+    if (!dict_) {
+        LevelBuilder builder(1);
+        Parse(text_, builder);
+        dict_ = std::make_unique<LazyDict>(builder.ExtractDict());
+    }
+    return *dict_;
+}
+
+Node LazyNode::ToNode() const {
+    if (text_.empty()) {
+        return value_;
+    }
+    TreeBuilder builder;
+    Parse(text_, builder);
+    return builder.Extract();
+}
+
+LazyDocument::LazyDocument(std::string text)
+    : text_(std::make_unique<const std::string>(std::move(text)))
+    , root_(ParseRoot(*text_)) {
+}
+
+LazyDocument LoadLazy(std::string text) {
+    return LazyDocument(std::move(text));
+}
+
+LazyDocument LoadLazy(std::istream& input) {
+    return LoadLazy(ReadAll(input));
+}
+
+}  // namespace json
@@ -0,0 +1,112 @@
+#pragma once
+//json_lazy.h
+#include "json.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+class LazyNode;
+using LazyArray = std::vector<LazyNode>;
+using LazyDict = std::map<std::string, LazyNode>;
+
+// Узел, массивы и словари которого разбираются при первом обращении.
+// До этого от них известен только текст: его границы находятся по
+// структурному индексу без разбора содержимого, и ошибки внутри
+// обнаруживаются лишь при разборе. AsArray и AsDict разбирают один уровень:
+// вложенные массивы и словари снова остаются неразобранными.
+// Первое обращение меняет узел, поэтому документ нельзя читать из
+// нескольких потоков без внешней синхронизации
+class LazyNode {
+public:
+    // Простое значение: null, bool, число или строка
+    explicit LazyNode(Node value);
+    // Неразобранный массив или словарь; text должен жить дольше узла
+    static LazyNode FromText(std::string_view text);
+
+    bool IsNull() const {
+        return text_.empty() && value_.IsNull();
+    }
+    bool IsBool() const {
+        return value_.IsBool();
+    }
+    bool IsInt() const {
+        return value_.IsInt();
+    }
+    bool IsPureDouble() const {
+        return value_.IsPureDouble();
+    }
+    bool IsDouble() const {
+        return value_.IsDouble();
+    }
+    bool IsString() const {
+        return value_.IsString();
+    }
+    bool IsArray() const {
+        return !text_.empty() && text_.front() == '[';
+    }
+    bool IsDict() const {
+        return !text_.empty() && text_.front() == '{';
+    }
+
+    bool AsBool() const {
+        return value_.AsBool();
+    }
+    int AsInt() const {
+        return value_.AsInt();
+    }
+    double AsDouble() const {
+        return value_.AsDouble();
+    }
+    const std::string& AsString() const {
+        return value_.AsString();
+    }
+    const LazyArray& AsArray() const;
+    const LazyDict& AsDict() const;
+
+    // Текст массива или словаря во входных данных; у простых значений пуст
+    std::string_view Text() const {
+        return text_;
+    }
+    // Было ли уже обращение к содержимому массива или словаря
+    bool IsMaterialized() const {
+        return array_ || dict_;
+    }
+
+    // Всё поддерево в обычном дереве Node
+    Node ToNode() const;
+
+private:
+    LazyNode() = default;
+
+    // Простое значение; у массивов и словарей — null
+    Node value_;
+    std::string_view text_;
+    mutable std::unique_ptr<LazyArray> array_;
+    mutable std::unique_ptr<LazyDict> dict_;
+};
+
+// Документ, разобранный только на верхнем уровне. Хранит входной текст,
+// на который ссылаются неразобранные узлы
+class LazyDocument {
+public:
+    explicit LazyDocument(std::string text);
+
+    const LazyNode& GetRoot() const {
+        return root_;
+    }
+
+private:
+    // Отдельно от документа, чтобы адреса текста не менялись при перемещении
+    std::unique_ptr<const std::string> text_;
+    LazyNode root_;
+};
+
+LazyDocument LoadLazy(std::string text);
+LazyDocument LoadLazy(std::istream& input);
+
+}  // namespace json
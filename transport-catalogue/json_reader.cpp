@@ -1,110 +1,420 @@
 #include "json_reader.h"
 // json_reader.cpp
+#include "json_fields.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <iostream>
+#include <ranges>
+#include <span>
 #include <sstream>
+#include <thread>
+#include <utility>
 using namespace std::literals;
+using request_keys::Key;
+using request_keys::RequestType;
 namespace input {
+  namespace {
+    // Сколько элементов base_requests разбирается одной пачкой: пачка целиком
+    // держится в памяти в виде плоских деревьев
+    constexpr size_t PARSE_BATCH = 8192;
+    // Сколько элементов поток берёт за раз
+    constexpr size_t PARSE_BLOCK = 64;
+
+    struct ParsedRequest {
+        json::FlatNode node;
+        // Ошибка разбора; передаётся дальше, когда до элемента дойдёт очередь
+        std::exception_ptr error;
+    };
+
+    struct ParsedBatch {
+        std::vector<ParsedRequest> requests;
+        // Арены потоков, в которых лежат узлы requests
+        std::vector<json::FlatDocument> arenas;
+    };
+
+    // Разбирает независимые значения в нескольких потоках
+    ParsedBatch ParseRequests(const std::vector<std::string_view>& texts) {
+        const size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                                     (texts.size() + PARSE_BLOCK - 1) / PARSE_BLOCK);
+        ParsedBatch batch{std::vector<ParsedRequest>(texts.size()), std::vector<json::FlatDocument>(thread_count)};
+        std::atomic<size_t> next_block = 0;
+        auto worker = [&](size_t thread) {
+            json::FlatBuilder builder;
+            for (size_t begin = next_block.fetch_add(PARSE_BLOCK); begin < texts.size();
+                 begin = next_block.fetch_add(PARSE_BLOCK)) {
+                const size_t end = std::min(begin + PARSE_BLOCK, texts.size());
+                for (size_t i = begin; i < end; ++i) {
+                    try {
+                        json::Parse(texts[i], builder);
+                        batch.requests[i].node = builder.ExtractRoot();
+                    } catch (...) {
+                        batch.requests[i].error = std::current_exception();
+                        builder.Reset();
+                    }
+                }
+            }
+            batch.arenas[thread] = builder.Extract();
+        };
+        {
+            std::vector<std::jthread> threads;
+            for (size_t i = 1; i < thread_count; ++i) {
+                threads.emplace_back(worker, i);
+            }
+            if (thread_count > 0) {
+                worker(0);
+            }
+        }
+        return batch;
+    }
+  }
 
-  transport::TransportCatalogue ReadTransportCatalogue(const json::Document& doc){
-    transport::TransportCatalogue catalogue;
-    const auto& root = doc.GetRoot().AsDict();
-    std::vector<std::tuple<std::string, std::string, int>> temp_distances;
+  void CatalogueLoader::Add(const json::Dict& request) {
+    AddRequest(request_keys::Fields(request));
+  }
 
-    auto base_requests_it = root.find("base_requests");
-    if (base_requests_it == root.end() || !base_requests_it->second.IsArray()) {
-        return catalogue;
+  void CatalogueLoader::Add(const json::FlatNode& request) {
+    AddRequest(request_keys::FlatFields(request.AsDict()));
+  }
+
+  template <typename Fields>
+  void CatalogueLoader::AddRequest(const Fields& fields) {
+    const auto* type = fields.Find(Key::Type);
+    if (!type) {
+        return;
+    }
+    switch (request_keys::ToRequestType(type->AsString())) {
+        case RequestType::Stop:
+            AddStop(fields);
+            break;
+        case RequestType::Bus:
+            AddBus(fields);
+            break;
+        default:
+            break;
+    }
+  }
+
+  template <typename Fields>
+  void CatalogueLoader::AddStop(const Fields& request) {
+    const auto* name = request.Find(Key::Name);
+    const auto* lat  = request.Find(Key::Latitude);
+    const auto* lng  = request.Find(Key::Longitude);
+    if (!name || !lat || !lng) {
+        return;
     }
 
-    const auto& base_requests = base_requests_it->second.AsArray();
+    geo::Coordinates coords{ lat->AsDouble(), lng->AsDouble() };
+    const transport::Stop* stop = catalogue_.AddStop(name->AsString(), coords);
 
-    // === 1-й проход: добавляем только остановки ===
-    for (const auto& request_node : base_requests) {
-        const auto& obj = request_node.AsDict();
-        auto type_it = obj.find("type");
-        if (type_it == obj.end() || type_it->second.AsString() != "Stop") {
-            continue;
+    const auto* road_distances = request.Find(Key::RoadDistances);
+    if (road_distances && road_distances->IsDict()) {
+        for (const auto& [other_stop_name, dist_node] : road_distances->AsDict()) {
+            if (!dist_node.IsInt()) {
+                continue;
+            }
+            if (const auto* other = catalogue_.FindStop(other_stop_name)) {
+                catalogue_.SetDistance(stop, other, dist_node.AsInt());
+            } else {
+                pending_distances_[catalogue_.Intern(other_stop_name)].push_back({stop, dist_node.AsInt()});
+            }
         }
+    }
 
-        auto name_it = obj.find("name");
-        auto lat_it  = obj.find("latitude");
-        auto lng_it  = obj.find("longitude");
+    // Разрешаем ссылки, ждавшие эту остановку
+    if (auto node = pending_distances_.extract(stop->name)) {
+        for (const auto& [from, meters] : node.mapped()) {
+            catalogue_.SetDistance(from, stop, meters);
+        }
+    }
+    if (auto node = pending_stop_refs_.extract(stop->name)) {
+        for (const auto& [bus_id, position] : node.mapped()) {
+            PendingBus& bus = pending_buses_[bus_id - first_pending_bus_id_];
+            bus.stops[position] = stop;
+            --bus.unresolved;
+        }
+        CommitReadyBuses();
+    }
+  }
+
+  template <typename Fields>
+  void CatalogueLoader::AddBus(const Fields& request) {
+    const auto* name = request.Find(Key::Name);
+    const auto* stops = request.Find(Key::Stops);
+    const auto* roundtrip = request.Find(Key::IsRoundtrip);
+    if (!name || !stops || !stops->IsArray()) {
+        return;
+    }
 
-        if (name_it == obj.end() || lat_it == obj.end() || lng_it == obj.end()) {
+    const size_t bus_id = first_pending_bus_id_ + pending_buses_.size();
+    PendingBus bus;
+    if (roundtrip && roundtrip->IsBool()) {
+        bus.is_roundtrip = roundtrip->AsBool();
+    }
+    const auto& stop_nodes = stops->AsArray();
+    bus.stops.reserve(stop_nodes.size());
+    for (const auto& stop_node : stop_nodes) {
+        if (!stop_node.IsString()) {
             continue;
         }
+        const auto* stop = catalogue_.FindStop(stop_node.AsString());
+        if (!stop) {
+            pending_stop_refs_[catalogue_.Intern(stop_node.AsString())].push_back({bus_id, bus.stops.size()});
+            ++bus.unresolved;
+        }
+        bus.stops.push_back(stop);
+    }
+
+    if (bus.unresolved == 0 && pending_buses_.empty()) {
+        bus.name = name->AsString();
+        CommitBus(bus);
+        ++first_pending_bus_id_;
+    } else {
+        bus.name = catalogue_.Intern(name->AsString());
+        pending_buses_.push_back(std::move(bus));
+    }
+  }
+
+  void CatalogueLoader::CommitBus(PendingBus& bus) {
+    // Остановки, так и не описанные в base_requests, остаются nullptr:
+    // справочник пропустит их сам
+    catalogue_.AddBus(bus.name, bus.stops, bus.is_roundtrip);
+  }
+
+  void CatalogueLoader::CommitReadyBuses() {
+    while (!pending_buses_.empty() && pending_buses_.front().unresolved == 0) {
+        CommitBus(pending_buses_.front());
+        pending_buses_.pop_front();
+        ++first_pending_bus_id_;
+    }
+  }
 
-        const std::string& stop_name = name_it->second.AsString();
-        geo::Coordinates coords{ lat_it->second.AsDouble(), lng_it->second.AsDouble() };
-        catalogue.AddStop(stop_name, coords);
+  transport::TransportCatalogue CatalogueLoader::Finish() {
+    for (auto& bus : pending_buses_) {
+        CommitBus(bus);
+    }
+    pending_buses_.clear();
+    pending_stop_refs_.clear();
+    pending_distances_.clear();
+    catalogue_.Freeze();
+    return std::move(catalogue_);
+  }
 
-        // Сохраняем road_distances на потом
-        auto rd_it = obj.find("road_distances");
-        if (rd_it != obj.end() && rd_it->second.IsDict()) {
-            for (const auto& [other_stop_name, dist_node] : rd_it->second.AsDict()) {
-                if (dist_node.IsInt()) {
-                    temp_distances.emplace_back(stop_name, other_stop_name, dist_node.AsInt());
-                }
-            }
+  transport::TransportCatalogue ReadTransportCatalogue(const json::Document& doc){
+    CatalogueLoader loader;
+    const auto& root = doc.GetRoot().AsDict();
+    auto base_requests_it = root.find("base_requests");
+    if (base_requests_it != root.end() && base_requests_it->second.IsArray()) {
+        for (const auto& request_node : base_requests_it->second.AsArray()) {
+            loader.Add(request_node.AsDict());
         }
     }
+    return loader.Finish();
+}
 
-    // === 2-й проход: сохраняем маршруты во временный буфер ===
-    std::vector<std::tuple<std::string, std::vector<std::string>, bool>> temp_buses;
+  DocumentReader::DocumentReader(bool load_base_requests) {
+    if (load_base_requests) {
+        loader_.emplace();
+    }
+  }
 
-    for (const auto& request_node : base_requests) {
-        const auto& obj = request_node.AsDict();
-        auto type_it = obj.find("type");
-        if (type_it == obj.end() || type_it->second.AsString() != "Bus") {
-            continue;
-        }
+  void DocumentReader::StartDict() {
+    if (depth_++ > 0) {
+        builder_.StartDict();
+    }
+  }
 
-        auto name_it = obj.find("name");
-        auto stops_it = obj.find("stops");
-        auto roundtrip_it = obj.find("is_roundtrip");
+  void DocumentReader::EndDict() {
+    if (--depth_ > 0) {
+        builder_.EndDict();
+        CommitValue();
+    }
+  }
 
-        if (name_it == obj.end() || stops_it == obj.end() || !stops_it->second.IsArray()) {
-            continue;
-        }
+  void DocumentReader::StartArray() {
+    if (depth_ == 0) {
+        throw std::logic_error("Not a dict"s);
+    }
+    if (depth_ == 1 && key_ == "base_requests"sv) {
+        in_base_requests_ = has_base_requests_ = true;
+    } else {
+        builder_.StartArray();
+    }
+    ++depth_;
+  }
+
+  void DocumentReader::EndArray() {
+    if (--depth_ == 1 && in_base_requests_) {
+        LoadPendingRequests();
+        in_base_requests_ = false;
+        return;
+    }
+    builder_.EndArray();
+    CommitValue();
+  }
+
+  void DocumentReader::Key(std::string key) {
+    if (depth_ > 1) {
+        builder_.Key(std::move(key));
+        return;
+    }
+    bool seen = root_.count(key) > 0 || (has_base_requests_ && key == "base_requests"sv);
+    if (auto it = skipped_sections_.find(key); it != skipped_sections_.end()) {
+        seen = std::exchange(it->second, true);
+    }
+    if (auto it = deferred_sections_.find(key); it != deferred_sections_.end()) {
+        seen = seen || it->second.has_value();
+    }
+    if (seen) {
+        throw json::ParsingError("Duplicate key '"s + key + "' have been found");
+    }
+    key_ = std::move(key);
+  }
 
-        const std::string& bus_name = name_it->second.AsString();
-        bool is_roundtrip = false;
-        if (roundtrip_it != obj.end() && roundtrip_it->second.IsBool()) {
-            is_roundtrip = roundtrip_it->second.AsBool();
-        }
+  void DocumentReader::Value(json::Node value) {
+    if (depth_ == 0) {
+        throw std::logic_error("Not a dict"s);
+    }
+    builder_.Value(std::move(value));
+    CommitValue();
+  }
 
-        std::vector<std::string> stops;
-        for (const auto& stop_node : stops_it->second.AsArray()) {
-            if (stop_node.IsString()) {
-                stops.push_back(stop_node.AsString());
-            }
+  bool DocumentReader::SkipContainer() {
+    if (in_base_requests_ && depth_ == 2) {
+        return loader_.has_value();
+    }
+    if (depth_ != 1) {
+        return false;
+    }
+    if (key_ == "base_requests"sv && !loader_) {
+        has_base_requests_ = true;
+        return true;
+    }
+    return skipped_sections_.count(key_) > 0 || deferred_sections_.count(key_) > 0;
+  }
+
+  void DocumentReader::RawValue(std::string_view text) {
+    if (!in_base_requests_) {
+        // Текст пропущенного раздела не нужен, отложенного — копируется:
+        // входной буфер живёт только до конца разбора
+        if (auto it = deferred_sections_.find(key_); it != deferred_sections_.end()) {
+            it->second.emplace(text);
         }
+        return;
+    }
+    pending_requests_.push_back(text);
+    if (pending_requests_.size() == PARSE_BATCH) {
+        LoadPendingRequests();
+    }
+  }
 
-        // Расширяем маршрут назад для некольцевого
-        // Расширяем маршрут назад для некольцевого
-        if (!is_roundtrip && stops.size() > 1) {
-          const size_t n = stops.size();          // исходное количество остановок
-          for (size_t k = 1; k < n; ++k) {        // добавляем ровно n-1 элементов
-              stops.push_back(stops[n - 1 - k]);
-          }
-      }
+  void DocumentReader::SkipSection(std::string key) {
+    skipped_sections_.emplace(std::move(key), false);
+  }
 
-        temp_buses.emplace_back(bus_name, std::move(stops), is_roundtrip);
+  void DocumentReader::DeferSection(std::string key) {
+    deferred_sections_.emplace(std::move(key), std::nullopt);
+  }
+
+  void DocumentReader::CommitValue() {
+    if (!builder_.IsComplete()) {
+        return;
+    }
+    json::Node value = builder_.Extract();
+    if (!in_base_requests_) {
+        if (skipped_sections_.count(key_) > 0) {
+            return;
+        }
+        root_.emplace(std::move(key_), std::move(value));
+    } else if (loader_) {
+        LoadPendingRequests();
+        loader_->Add(value.AsDict());
+    }
+  }
+
+  void DocumentReader::LoadPendingRequests() {
+    const ParsedBatch batch = ParseRequests(pending_requests_);
+    pending_requests_.clear();
+    for (const ParsedRequest& request : batch.requests) {
+        if (request.error) {
+            std::rethrow_exception(request.error);
+        }
+        loader_->Add(request.node);
     }
+  }
+
+  json::Document DocumentReader::ExtractDocument() {
+    return json::Document(json::Node(std::move(root_)));
+  }
 
-    // === 3-й проход: теперь добавляем маршруты, когда все остановки гарантированно есть ===
-    for (const auto& [bus_name, stops, is_roundtrip] : temp_buses) {
-        catalogue.AddBus(bus_name, stops, is_roundtrip);
+  json::LazyDocument DocumentReader::ExtractDeferredSection(std::string_view key) {
+    auto it = deferred_sections_.find(key);
+    if (it == deferred_sections_.end() || !it->second) {
+        return json::LoadLazy("null"s);
     }
+    return json::LoadLazy(std::move(*std::exchange(it->second, std::string())));
+  }
+
+  transport::TransportCatalogue DocumentReader::ExtractCatalogue() {
+    transport::TransportCatalogue catalogue = loader_->Finish();
+    loader_.reset();
+    return catalogue;
+  }
+
+transport::CatalogueUpdate ReadCatalogueUpdate(const json::Array& requests) {
+    transport::CatalogueUpdate update;
+    for (const auto& request_node : requests) {
+        const request_keys::Fields obj(request_node.AsDict());
+        const json::Node* type = obj.Find(Key::Type);
+        const json::Node* name = obj.Find(Key::Name);
+        if (!type || !name) {
+            continue;
+        }
 
-    // === Применяем расстояния между остановками ===
-    for (const auto& [from_name, to_name, dist] : temp_distances) {
-        const auto* from = catalogue.FindStop(from_name);
-        const auto* to = catalogue.FindStop(to_name);
-        if (from && to) {
-            catalogue.SetDistance(from, to, dist);
+        switch (request_keys::ToRequestType(type->AsString())) {
+            case RequestType::Stop: {
+                const json::Node* lat = obj.Find(Key::Latitude);
+                const json::Node* lng = obj.Find(Key::Longitude);
+                if (!lat || !lng) {
+                    continue;
+                }
+                transport::StopUpdate stop{name->AsString(), {lat->AsDouble(), lng->AsDouble()}, {}};
+                const json::Node* road_distances = obj.Find(Key::RoadDistances);
+                if (road_distances && road_distances->IsDict()) {
+                    for (const auto& [other_stop_name, dist_node] : road_distances->AsDict()) {
+                        if (dist_node.IsInt()) {
+                            stop.road_distances.emplace_back(other_stop_name, dist_node.AsInt());
+                        }
+                    }
+                }
+                update.stops.push_back(std::move(stop));
+                break;
+            }
+            case RequestType::Bus: {
+                const json::Node* stops = obj.Find(Key::Stops);
+                const json::Node* roundtrip = obj.Find(Key::IsRoundtrip);
+                if (!stops || !stops->IsArray()) {
+                    continue;
+                }
+                transport::BusUpdate bus;
+                bus.name = name->AsString();
+                if (roundtrip && roundtrip->IsBool()) {
+                    bus.is_roundtrip = roundtrip->AsBool();
+                }
+                for (const auto& stop_node : stops->AsArray()) {
+                    if (stop_node.IsString()) {
+                        bus.stops.push_back(stop_node.AsString());
+                    }
+                }
+                update.buses.push_back(std::move(bus));
+                break;
+            }
+            default:
+                break;
         }
     }
-      return catalogue;
+    return update;
 }
 } // namespace input
 namespace render_config
@@ -135,41 +445,60 @@ namespace render_config
 
     render::RenderSettings ParseRenderSettings(const json::Dict& settings_json){
         render::RenderSettings settings;
-        if (auto val = GetIf<double>(settings_json, "width")) settings.width = *val;
-        if (auto val = GetIf<double>(settings_json, "height")) settings.height = *val;
-        if (auto val = GetIf<double>(settings_json, "padding")) settings.padding = *val;
-        if (auto val = GetIf<double>(settings_json, "line_width")) settings.line_width = *val;
-        if (auto val = GetIf<double>(settings_json, "stop_radius")) settings.stop_radius = *val;
-        if (auto val = GetIf<int>(settings_json, "bus_label_font_size")) settings.bus_label_font_size = *val;
-        if (auto val = GetIf<int>(settings_json, "stop_label_font_size")) settings.stop_label_font_size = *val;
-        if (auto val = GetIf<double>(settings_json, "underlayer_width")) settings.underlayer_width = *val;
-
-        if (auto it = settings_json.find("bus_label_offset");
-            it != settings_json.end() && it -> second.IsArray()){
-                const auto& arr = it -> second.AsArray();
-                if (arr.size() == 2){
-                    settings.bus_label_offset = { arr[0].AsDouble(), arr[1].AsDouble()};
-                }
-        }
-        if (auto it = settings_json.find("stop_label_offset");
-            it != settings_json.end() && it->second.IsArray()) {
-             const auto& arr = it->second.AsArray();
-             if (arr.size() == 2) {
-                    settings.stop_label_offset = { arr[0].AsDouble(), arr[1].AsDouble() };
+        // Смещение подписи: массив из двух чисел
+        auto parse_offset = [](const json::Node& node, svg::Point& offset) {
+            if (node.IsArray()) {
+                const auto& arr = node.AsArray();
+                if (arr.size() == 2) {
+                    offset = { arr[0].AsDouble(), arr[1].AsDouble() };
                 }
-        }
-
-
-        if (auto it = settings_json.find("underlayer_color");
-            it != settings_json.end()) {
-            settings.underlayer_color = ParseColor(it->second);
-        }
-
-
-        if (auto it = settings_json.find("color_palette");
-            it != settings_json.end() && it->second.IsArray()) {
-            for (const auto& node : it->second.AsArray()) {
-                settings.color_palette.push_back(ParseColor(node));
+            }
+        };
+
+        for (const auto& [key, node] : settings_json) {
+            switch (request_keys::ToKey(key)) {
+                case Key::Width:
+                    if (auto val = GetIf<double>(node)) settings.width = *val;
+                    break;
+                case Key::Height:
+                    if (auto val = GetIf<double>(node)) settings.height = *val;
+                    break;
+                case Key::Padding:
+                    if (auto val = GetIf<double>(node)) settings.padding = *val;
+                    break;
+                case Key::LineWidth:
+                    if (auto val = GetIf<double>(node)) settings.line_width = *val;
+                    break;
+                case Key::StopRadius:
+                    if (auto val = GetIf<double>(node)) settings.stop_radius = *val;
+                    break;
+                case Key::BusLabelFontSize:
+                    if (auto val = GetIf<int>(node)) settings.bus_label_font_size = *val;
+                    break;
+                case Key::StopLabelFontSize:
+                    if (auto val = GetIf<int>(node)) settings.stop_label_font_size = *val;
+                    break;
+                case Key::UnderlayerWidth:
+                    if (auto val = GetIf<double>(node)) settings.underlayer_width = *val;
+                    break;
+                case Key::BusLabelOffset:
+                    parse_offset(node, settings.bus_label_offset);
+                    break;
+                case Key::StopLabelOffset:
+                    parse_offset(node, settings.stop_label_offset);
+                    break;
+                case Key::UnderlayerColor:
+                    settings.underlayer_color = ParseColor(node);
+                    break;
+                case Key::ColorPalette:
+                    if (node.IsArray()) {
+                        for (const auto& color : node.AsArray()) {
+                            settings.color_palette.push_back(ParseColor(color));
+                        }
+                    }
+                    break;
+                default:
+                    break;
             }
         }
     return settings;
@@ -177,189 +506,394 @@ namespace render_config
 } // namespace render_config
 
 namespace output {
+namespace {
+
+struct ErrorResponse {
+    int request_id;
+};
+
+struct BusResponse {
+    int request_id;
+    transport::BusInfo info;
+};
+
+struct StopResponse {
+    int request_id;
+    const std::vector<const transport::Bus*>& buses;
+};
+
+struct RouteResponse {
+    int request_id;
+    const transport_router::RouteInfo& route;
+};
+
+struct NearbyResponse {
+    int request_id;
+    const std::vector<spatial::NearbyStop>& stops;
+};
+
+struct CommonBusesResponse {
+    int request_id;
+    const std::vector<const transport::Bus*>& buses;
+};
+
+struct SearchResponse {
+    int request_id;
+    const std::vector<const transport::Stop*>& stops;
+    const std::vector<const transport::Bus*>& buses;
+};
+
+struct NetworkStatsResponse {
+    int request_id;
+    const transport::NetworkStats& stats;
+    bool per_bus;
+};
+
+struct MapResponse {
+    int request_id;
+    std::string map;
+};
+
+struct UpdateResponse {
+    int request_id;
+    const transport::CatalogueDelta& delta;
+};
+
+// Названия остановок или маршрутов без копирования
+template <typename T>
+auto Names(const std::vector<const T*>& items) {
+    return std::views::transform(items, [](const T* item) {
+        return item->name;
+    });
+}
 
-StatResponse ReadStatRequests(const json::Document& doc,
-                              const transport::TransportCatalogue& catalogue,
-                              const render::MapRenderer& renderer,
-                              const transport_router::TransportRouter& router) {
-    const auto& root = doc.GetRoot().AsDict();
-    json::Array responses;
-
-    auto stat_requests_it = root.find("stat_requests");
-    if (stat_requests_it == root.end() || !stat_requests_it->second.IsArray()) {
-        return StatResponse{std::move(responses)};
-    }
+}  // namespace
+}  // namespace output
+
+// Описания ответов для json::Write: ключи по возрастанию, как в Print
+namespace json {
+
+template <>
+struct ObjectFields<output::ErrorResponse> {
+    static constexpr std::tuple FIELDS{
+        Field{"error_message"sv, [](const output::ErrorResponse&) { return "not found"sv; }},
+        Field{"request_id"sv, &output::ErrorResponse::request_id},
+    };
+};
+
+template <>
+struct ObjectFields<output::BusResponse> {
+    static constexpr std::tuple FIELDS{
+        Field{"curvature"sv, [](const output::BusResponse& response) { return response.info.curvature; }},
+        Field{"request_id"sv, &output::BusResponse::request_id},
+        Field{"route_length"sv, [](const output::BusResponse& response) { return response.info.route_length; }},
+        Field{"stop_count"sv, [](const output::BusResponse& response) { return response.info.total_stops; }},
+        Field{"unique_stop_count"sv, [](const output::BusResponse& response) { return response.info.unique_stops; }},
+    };
+};
+
+template <>
+struct ObjectFields<output::StopResponse> {
+    static constexpr std::tuple FIELDS{
+        Field{"buses"sv, [](const output::StopResponse& response) { return output::Names(response.buses); }},
+        Field{"request_id"sv, &output::StopResponse::request_id},
+    };
+};
+
+// Ожидание: stop_name, time, type; поездка: bus, span_count, time, type
+template <>
+struct ObjectFields<transport_router::RouteItem> {
+    using Item = transport_router::RouteItem;
+
+    static constexpr std::tuple FIELDS{
+        Field{"bus"sv, [](const Item& item) {
+            return item.type == Item::Type::Bus ? std::optional<std::string_view>(item.name) : std::nullopt;
+        }},
+        Field{"span_count"sv, [](const Item& item) {
+            return item.type == Item::Type::Bus ? std::optional<int>(item.span_count) : std::nullopt;
+        }},
+        Field{"stop_name"sv, [](const Item& item) {
+            return item.type == Item::Type::Wait ? std::optional<std::string_view>(item.name) : std::nullopt;
+        }},
+        Field{"time"sv, &Item::time},
+        Field{"type"sv, [](const Item& item) { return item.type == Item::Type::Wait ? "Wait"sv : "Bus"sv; }},
+    };
+};
+
+template <>
+struct ObjectFields<output::RouteResponse> {
+    static constexpr std::tuple FIELDS{
+        Field{"items"sv, [](const output::RouteResponse& response) -> const auto& { return response.route.items; }},
+        Field{"request_id"sv, &output::RouteResponse::request_id},
+        Field{"total_time"sv, [](const output::RouteResponse& response) { return response.route.total_time; }},
+    };
+};
+
+template <>
+struct ObjectFields<spatial::NearbyStop> {
+    static constexpr std::tuple FIELDS{
+        Field{"distance"sv, &spatial::NearbyStop::distance},
+        Field{"name"sv, [](const spatial::NearbyStop& stop) { return stop.stop->name; }},
+    };
+};
+
+template <>
+struct ObjectFields<output::NearbyResponse> {
+    static constexpr std::tuple FIELDS{
+        Field{"request_id"sv, &output::NearbyResponse::request_id},
+        Field{"stops"sv, [](const output::NearbyResponse& response) -> const auto& { return response.stops; }},
+    };
+};
+
+template <>
+struct ObjectFields<output::CommonBusesResponse> {
+    static constexpr std::tuple FIELDS{
+        Field{"buses"sv, [](const output::CommonBusesResponse& response) { return output::Names(response.buses); }},
+        Field{"request_id"sv, &output::CommonBusesResponse::request_id},
+    };
+};
+
+template <>
+struct ObjectFields<output::SearchResponse> {
+    static constexpr std::tuple FIELDS{
+        Field{"buses"sv, [](const output::SearchResponse& response) { return output::Names(response.buses); }},
+        Field{"request_id"sv, &output::SearchResponse::request_id},
+        Field{"stops"sv, [](const output::SearchResponse& response) { return output::Names(response.stops); }},
+    };
+};
+
+template <>
+struct ObjectFields<transport::BusStats> {
+    static constexpr std::tuple FIELDS{
+        Field{"curvature"sv, [](const transport::BusStats& bus) { return bus.info.curvature; }},
+        Field{"name"sv, [](const transport::BusStats& bus) { return bus.bus->name; }},
+        Field{"route_length"sv, [](const transport::BusStats& bus) { return bus.info.route_length; }},
+        Field{"stop_count"sv, [](const transport::BusStats& bus) { return bus.info.total_stops; }},
+        Field{"unique_stop_count"sv, [](const transport::BusStats& bus) { return bus.info.unique_stops; }},
+    };
+};
+
+template <>
+struct ObjectFields<output::NetworkStatsResponse> {
+    using Response = output::NetworkStatsResponse;
+
+    static constexpr std::tuple FIELDS{
+        Field{"bus_count"sv, [](const Response& response) { return response.stats.bus_count; }},
+        // Показатели маршрутов — только по флагу per_bus
+        Field{"buses"sv, [](const Response& response) {
+            return response.per_bus ? std::optional<std::span<const transport::BusStats>>(response.stats.buses)
+                                    : std::nullopt;
+        }},
+        Field{"mean_curvature"sv, [](const Response& response) { return response.stats.mean_curvature; }},
+        Field{"request_id"sv, &Response::request_id},
+        Field{"stop_count"sv, [](const Response& response) { return response.stats.stop_count; }},
+        Field{"total_route_length"sv, [](const Response& response) { return response.stats.total_route_length; }},
+        Field{"total_stops"sv, [](const Response& response) { return response.stats.total_stops; }},
+    };
+};
+
+template <>
+struct ObjectFields<output::MapResponse> {
+    static constexpr std::tuple FIELDS{
+        Field{"map"sv, &output::MapResponse::map},
+        Field{"request_id"sv, &output::MapResponse::request_id},
+    };
+};
+
+// Число добавленных остановок, изменённых маршрутов и перенесённых остановок
+template <>
+struct ObjectFields<output::UpdateResponse> {
+    using Response = output::UpdateResponse;
+
+    static constexpr std::tuple FIELDS{
+        Field{"added_stops"sv, [](const Response& response) { return static_cast<int>(response.delta.added_stops.size()); }},
+        Field{"changed_buses"sv, [](const Response& response) { return static_cast<int>(response.delta.changed_buses.size()); }},
+        Field{"moved_stops"sv, [](const Response& response) { return static_cast<int>(response.delta.moved_stops.size()); }},
+        Field{"request_id"sv, &Response::request_id},
+    };
+};
+
+}  // namespace json
 
-    for (const auto& request : stat_requests_it->second.AsArray()) {
-        const auto& obj = request.AsDict();
+namespace output {
 
-        auto id_it = obj.find("id");
-        if (id_it == obj.end() || !id_it->second.IsInt()) {
-            continue;
-        }
-        int request_id = id_it->second.AsInt();
+bool WriteStatResponse(const json::Dict& request,
+                       const transport::TransportCatalogue& catalogue,
+                       const render::MapRenderer& renderer,
+                       const transport_router::TransportRouter& router,
+                       json::Writer& writer) {
+    const request_keys::Fields obj(request);
 
-        auto type_it = obj.find("type");
-        if (type_it == obj.end() || !type_it->second.IsString()) {
-            continue;
-        }
-        const std::string& type = type_it->second.AsString();
+    const json::Node* id = obj.Find(Key::Id);
+    if (!id || !id->IsInt()) {
+        return false;
+    }
+    int request_id = id->AsInt();
 
-        if (type == "Bus") {
-            auto name_it = obj.find("name");
-            if (name_it == obj.end() || !name_it->second.IsString()) {
-                continue;
+    switch (obj.GetType()) {
+        case RequestType::Bus: {
+            const json::Node* name = obj.Find(Key::Name);
+            if (!name || !name->IsString()) {
+                return false;
             }
-            const std::string& bus_name = name_it->second.AsString();
-            auto bus_info = catalogue.GetBusInfo(bus_name);
+            auto bus_info = catalogue.GetBusInfo(name->AsString());
 
             if (!bus_info.exists) {
-                responses.push_back(
-                    json::Builder{}
-                        .StartDict()
-                            .Key("request_id").Value(request_id)
-                            .Key("error_message").Value("not found")
-                        .EndDict()
-                        .Build()
-                );
+                json::Write(writer, ErrorResponse{request_id});
             } else {
-                responses.push_back(
-                    json::Builder{}
-                        .StartDict()
-                            .Key("request_id").Value(request_id)
-                            .Key("stop_count").Value(bus_info.total_stops)
-                            .Key("unique_stop_count").Value(bus_info.unique_stops)
-                            .Key("route_length").Value(bus_info.route_length)
-                            .Key("curvature").Value(bus_info.curvature)
-                        .EndDict()
-                        .Build()
-                );
+                json::Write(writer, BusResponse{request_id, bus_info});
+            }
+            break;
+        }
+        case RequestType::Stop: {
+            const json::Node* name = obj.Find(Key::Name);
+            if (!name || !name->IsString()) {
+                return false;
             }
+            const std::string& stop_name = name->AsString();
 
-        } else if (type == "Stop") {
-            auto name_it = obj.find("name");
-            if (name_it == obj.end() || !name_it->second.IsString()) {
-                continue;
+            if (!catalogue.FindStop(stop_name)) {
+                json::Write(writer, ErrorResponse{request_id});
+            } else {
+                json::Write(writer, StopResponse{request_id, catalogue.GetBusesForStop(stop_name)});
             }
-            const std::string& stop_name = name_it->second.AsString();
-
-            const transport::Stop* stop_ptr = catalogue.FindStop(stop_name);
-            if (!stop_ptr) {
-                responses.push_back(
-                    json::Builder{}
-                        .StartDict()
-                            .Key("request_id").Value(request_id)
-                            .Key("error_message").Value("not found")
-                        .EndDict()
-                        .Build()
-                );
-                continue;
+            break;
+        }
+        case RequestType::Route: {
+            const auto* from = catalogue.FindStop(obj.At(Key::From).AsString());
+            const auto* to   = catalogue.FindStop(obj.At(Key::To).AsString());
+
+            // Нет остановки или пути между ними — not found
+            const auto route = from && to ? router.GetOptimalRoute(from, to) : std::nullopt;
+            if (!route) {
+                json::Write(writer, ErrorResponse{request_id});
+            } else {
+                json::Write(writer, RouteResponse{request_id, *route});
             }
-
-            auto buses_set = catalogue.GetBusesForStop(stop_name);
-            json::Builder builder;
-            auto array_ctx = builder
-                .StartDict()
-                    .Key("request_id").Value(request_id)
-                    .Key("buses")
-                    .StartArray();
-
-            for (const auto& bus_name : buses_set) {
-                array_ctx.Value(std::string(bus_name));
+            break;
+        }
+        case RequestType::Nearby: {
+            // Ближайшие к точке остановки: count ближайших, все в радиусе radius
+            // метров или не более count в радиусе radius
+            const json::Node* lat = obj.Find(Key::Latitude);
+            const json::Node* lng = obj.Find(Key::Longitude);
+            const json::Node* count_node = obj.Find(Key::Count);
+            const json::Node* radius = obj.Find(Key::Radius);
+            const bool has_count = count_node && count_node->IsInt();
+            const bool has_radius = radius && radius->IsDouble();
+            if (!lat || !lng || (!has_count && !has_radius)) {
+                return false;
             }
 
-            responses.push_back(
-                builder.EndArray().EndDict().Build()
-            );
-
-        }else if (type == "Route") {
-          // находим остановки
-          const auto* from = catalogue.FindStop(obj.at("from").AsString());
-          const auto* to   = catalogue.FindStop(obj.at("to").AsString());
-
-          // если остановок нет — сразу not found
-          if (!from || !to) {
-              responses.push_back(
-                  json::Builder{}
-                      .StartDict()
-                          .Key("request_id").Value(request_id)
-                          .Key("error_message").Value("not found")
-                      .EndDict()
-                  .Build()
-              );
-              continue;
-          }
-
-          // строим маршрут
-          auto route = router.GetOptimalRoute(from, to);
-          if (!route) {
-              responses.push_back(
-                  json::Builder{}
-                      .StartDict()
-                          .Key("request_id").Value(request_id)
-                          .Key("error_message").Value("not found")
-                      .EndDict()
-                  .Build()
-              );
-              continue;
-          }
-
-          // --- теперь собираем JSON ответа ---
-          json::Builder builder;
-
-          // 1) начинаем корневой dict
-          builder
-              .StartDict()
-                  .Key("request_id").Value(request_id)
-                  .Key("total_time").Value(route->total_time)
-                  // 2) открываем массив items
-                  .Key("items");
-          auto array_ctx = builder.StartArray();
-
-          // 3) пробегаем по каждому шагу маршрута
-          for (const auto& item : route->items) {
-              if (item.type == transport_router::RouteItem::Type::Wait) {
-                  array_ctx
-                      .StartDict()
-                          .Key("type").Value("Wait")
-                          .Key("stop_name").Value(item.name)
-                          .Key("time").Value(item.time)
-                      .EndDict();
-              } else {
-                  array_ctx
-                      .StartDict()
-                          .Key("type").Value("Bus")
-                          .Key("bus").Value(item.name)
-                          .Key("span_count").Value(item.span_count)
-                          .Key("time").Value(item.time)
-                      .EndDict();
-              }
-          }
-
-          // 4) закрываем массив и dict, строим Node и пушим в responses
-          responses.push_back(
-              array_ctx
-                  .EndArray()  // возвращает Builder&
-                  .EndDict()   // возвращает Builder&
-                  .Build()     // возвращает Node
-          );
-      } else if (type == "Map") {
+            const geo::Coordinates center{lat->AsDouble(), lng->AsDouble()};
+            const size_t count = has_count ? static_cast<size_t>(std::max(0, count_node->AsInt())) : 0;
+            std::vector<spatial::NearbyStop> stops = has_radius
+                ? catalogue.FindStopsWithin(center, radius->AsDouble())
+                : catalogue.FindNearestStops(center, count);
+            if (has_radius && has_count && stops.size() > count) {
+                stops.resize(count);
+            }
+            json::Write(writer, NearbyResponse{request_id, stops});
+            break;
+        }
+        case RequestType::CommonBuses: {
+            // Маршруты, на которых можно доехать между всеми указанными остановками
+            const json::Node* stop_names = obj.Find(Key::Stops);
+            if (!stop_names || !stop_names->IsArray()) {
+                return false;
+            }
+            std::vector<const transport::Stop*> stops;
+            for (const auto& stop_node : stop_names->AsArray()) {
+                const transport::Stop* stop = stop_node.IsString() ? catalogue.FindStop(stop_node.AsString()) : nullptr;
+                if (!stop) {
+                    stops.clear();
+                    break;
+                }
+                stops.push_back(stop);
+            }
+            if (stops.empty()) {
+                json::Write(writer, ErrorResponse{request_id});
+            } else {
+                json::Write(writer, CommonBusesResponse{request_id, catalogue.GetCommonBuses(stops)});
+            }
+            break;
+        }
+        case RequestType::Search: {
+            // Подсказки по началу названия: до count остановок и до count маршрутов
+            const json::Node* prefix_node = obj.Find(Key::Prefix);
+            const json::Node* count_node = obj.Find(Key::Count);
+            if (!prefix_node || !prefix_node->IsString()) {
+                return false;
+            }
+            size_t count = 10;
+            if (count_node && count_node->IsInt()) {
+                count = static_cast<size_t>(std::max(0, count_node->AsInt()));
+            }
+            const std::string& prefix = prefix_node->AsString();
+            json::Write(writer, SearchResponse{request_id, catalogue.SearchStops(prefix, count),
+                                               catalogue.SearchBuses(prefix, count)});
+            break;
+        }
+        case RequestType::NetworkStats: {
+            // Сводка по всей сети; показатели отдельных маршрутов — по флагу per_bus
+            const json::Node* per_bus_node = obj.Find(Key::PerBus);
+            const bool per_bus = per_bus_node && per_bus_node->IsBool() && per_bus_node->AsBool();
+            json::Write(writer, NetworkStatsResponse{request_id, catalogue.GetNetworkStats(per_bus), per_bus});
+            break;
+        }
+        case RequestType::Map: {
             std::ostringstream svg_stream;
             svg::Document map = renderer.RenderMap(catalogue);
             map.Render(svg_stream);
-
-            responses.push_back(
-                json::Builder{}
-                    .StartDict()
-                        .Key("request_id").Value(request_id)
-                        .Key("map").Value(svg_stream.str())
-                    .EndDict()
-                    .Build()
-            );
+            json::Write(writer, MapResponse{request_id, svg_stream.str()});
+            break;
         }
+        // Update меняет справочник и обрабатывается WriteUpdateResponse
+        case RequestType::Update:
+        case RequestType::Unknown:
+            return false;
+    }
+    return true;
+}
+
+bool WriteUpdateResponse(const json::Dict& request,
+                         transport::VersionedCatalogue& versions,
+                         json::Writer& writer) {
+    const request_keys::Fields obj(request);
+
+    const json::Node* id = obj.Find(Key::Id);
+    const json::Node* requests = obj.Find(Key::BaseRequests);
+    if (obj.GetType() != RequestType::Update || !id || !id->IsInt() || !requests || !requests->IsArray()) {
+        return false;
     }
+    // Разбор может бросить исключение, пока версия ещё не опубликована
+    const transport::CatalogueUpdate update = input::ReadCatalogueUpdate(requests->AsArray());
+    // Сводка ссылается на остановки и маршруты новой версии, поэтому
+    // result держит её, пока сводка не записана
+    const transport::VersionedCatalogue::UpdateResult result = versions.Update(update);
+    json::Write(writer, UpdateResponse{id->AsInt(), result.delta});
+    return true;
+}
 
-    return StatResponse{std::move(responses)};
+void WriteStatRequests(const json::LazyNode& stat_requests,
+                       const transport::TransportCatalogue& catalogue,
+                       const render::MapRenderer& renderer,
+                       const transport_router::TransportRouter& router,
+                       std::ostream& output) {
+    json::Writer writer(output);
+    writer.StartArray();
+    if (stat_requests.IsArray()) {
+        // AsArray разбирает только верхний уровень: запросы остаются текстом,
+        // и дерево каждого живёт, пока на него отвечают
+        for (const json::LazyNode& item : stat_requests.AsArray()) {
+            const json::Node request = item.ToNode();
+            // Каждый ответ уходит в поток сразу, не дожидаясь остальных
+            if (WriteStatResponse(request.AsDict(), catalogue, renderer, router, writer)) {
+                writer.Flush();
+            }
+        }
+    }
+    writer.EndArray();
 }
 
   } // namespace output
@@ -369,5 +903,8 @@ StatResponse ReadStatRequests(const json::Document& doc,
     settings.bus_velocity = settings_json.at("bus_velocity").AsDouble();
     return settings;
 }
-
-
+  serialization::SerializationSettings serialization_config::ParseSerializationSettings(const json::Dict& settings_json) {
+    serialization::SerializationSettings settings;
+    settings.file = settings_json.at("file").AsString();
+    return settings;
+}
@@ -1,26 +1,168 @@
 #pragma once
 //json_reader.h
 #include "json.h"
+#include "json_flat.h"
+#include "json_lazy.h"
 #include "transport_catalogue.h"
 #include "map_renderer.h"
-#include "json_builder.h"
 #include "transport_router.h"
+#include "catalogue_version.h"
+#include "serialization.h"
+#include "request_keys.h"
 
 namespace input {
 
+    // Однопроходный загрузчик base_requests: запросы подаются по одному в
+    // порядке следования и после разбора не нужны. Остановка добавляется в
+    // справочник сразу, маршрут — как только известны все его остановки.
+    // Ссылки на ещё не описанные остановки (в stops и road_distances) ждут в
+    // таблице отложенных ссылок и разрешаются при появлении остановки.
+    // Маршруты попадают в справочник в исходном порядке
+    class CatalogueLoader {
+    public:
+        void Add(const json::Dict& request);
+        // Запрос, разобранный в плоское дерево; строки узла нужны только на
+        // время вызова
+        void Add(const json::FlatNode& request);
+        // Отбрасывает ссылки на так и не описанные остановки и возвращает
+        // замороженный справочник
+        transport::TransportCatalogue Finish();
+
+    private:
+        struct PendingBus {
+            std::string_view name;
+            // nullptr — остановка ещё не описана
+            std::vector<const transport::Stop*> stops;
+            bool is_roundtrip = false;
+            size_t unresolved = 0;
+        };
+        struct PendingStopRef {
+            size_t bus_id;
+            size_t position;
+        };
+        struct PendingDistance {
+            const transport::Stop* from;
+            int meters;
+        };
+
+        template <typename Fields>
+        void AddRequest(const Fields& request);
+        template <typename Fields>
+        void AddStop(const Fields& request);
+        template <typename Fields>
+        void AddBus(const Fields& request);
+        void CommitBus(PendingBus& bus);
+        void CommitReadyBuses();
+
+        transport::TransportCatalogue catalogue_;
+        std::deque<PendingBus> pending_buses_;
+        // Сквозной номер pending_buses_.front()
+        size_t first_pending_bus_id_ = 0;
+        // Имя неописанной остановки (в арене справочника) -> ссылки на неё
+        std::unordered_map<std::string_view, std::vector<PendingStopRef>> pending_stop_refs_;
+        std::unordered_map<std::string_view, std::vector<PendingDistance>> pending_distances_;
+    };
+
     transport::TransportCatalogue ReadTransportCatalogue(const json::Document& doc);
 
+    // Читает входной документ потоково (см. json::Parse). Элементы
+    // base_requests не разбираются по ходу чтения: парсер только находит их
+    // границы по структурному индексу. Накопленные пачкой элементы
+    // разбираются в нескольких потоках в плоские деревья (json::FlatNode) —
+    // по одной арене на поток, — передаются в CatalogueLoader в исходном
+    // порядке и освобождаются вместе с аренами, так что дерево всего массива
+    // не строится, а справочник не зависит от числа потоков. Остальные разделы
+    // корня собираются в документ без base_requests; отложенные разделы
+    // (см. DeferSection) — например, stat_requests — только копируются
+    // текстом и разбираются потом по частям
+    class DocumentReader final : public json::Handler {
+    public:
+        // load_base_requests = false: base_requests разбираются, но не загружаются
+        explicit DocumentReader(bool load_base_requests = true);
+
+        void StartDict() override;
+        void EndDict() override;
+        void StartArray() override;
+        void EndArray() override;
+        void Key(std::string key) override;
+        void Value(json::Node value) override;
+        bool SkipContainer() override;
+        void RawValue(std::string_view text) override;
+
+        // Раздел корня, который не нужен: его массив или словарь не
+        // разбирается (см. json::Handler::SkipContainer), а в документ он
+        // не попадает
+        void SkipSection(std::string key);
+        // Раздел корня, который разберут позже и по частям: его массив или
+        // словарь не разбирается при чтении, а текст сохраняется и отдаётся
+        // ExtractDeferredSection. Ошибки внутри раздела обнаружатся, только
+        // когда до них дойдёт разбор
+        void DeferSection(std::string key);
+
+        // Корень документа без base_requests и отложенных разделов
+        json::Document ExtractDocument();
+        // Отложенный раздел, корень которого — неразобранный массив или
+        // словарь (см. json::LazyNode). Если в документе такого раздела нет
+        // или он не массив и не словарь, корень — null
+        json::LazyDocument ExtractDeferredSection(std::string_view key);
+        // Только если base_requests загружались
+        transport::TransportCatalogue ExtractCatalogue();
+
+    private:
+        // Передаёт собранное значение раздела или запроса по назначению
+        void CommitValue();
+        // Разбирает накопленные элементы base_requests и передаёт загрузчику
+        void LoadPendingRequests();
+
+        // Пусто, если base_requests не загружаются или справочник уже забран:
+        // контейнеры справочника, из которого переместили данные, ссылаются на
+        // арену нового и должны быть уничтожены раньше него
+        std::optional<CatalogueLoader> loader_;
+        json::TreeBuilder builder_;
+        json::Dict root_;
+        std::string key_;
+        // Глубина вложенности: 1 — внутри корневого словаря
+        size_t depth_ = 0;
+        bool in_base_requests_ = false;
+        bool has_base_requests_ = false;
+        // Текст элементов base_requests, ещё не переданных загрузчику
+        std::vector<std::string_view> pending_requests_;
+        // Ненужный раздел -> встречался ли он уже
+        std::map<std::string, bool, std::less<>> skipped_sections_;
+        // Отложенный раздел -> его текст, если он уже встречался
+        std::map<std::string, std::optional<std::string>, std::less<>> deferred_sections_;
+    };
+
+    // Читает добавленные или изменённые остановки и маршруты в формате
+    // base_requests для TransportCatalogue::WithUpdate
+    transport::CatalogueUpdate ReadCatalogueUpdate(const json::Array& requests);
+
 }// namespace input
 
 namespace output {
-    struct StatResponse
-    {
-        std::vector<json::Node> responses;
-    };
-    StatResponse ReadStatRequests(const json::Document& doc,
-                                  const transport::TransportCatalogue& catalogue,
-                                  const render::MapRenderer& renderer,
-                                  const transport_router::TransportRouter& router);
+    // Отвечает на один запрос из stat_requests, записывая ответ в writer.
+    // Возвращает false, если запрос пропущен: нет id, типа или нужных полей
+    bool WriteStatResponse(const json::Dict& request,
+                           const transport::TransportCatalogue& catalogue,
+                           const render::MapRenderer& renderer,
+                           const transport_router::TransportRouter& router,
+                           json::Writer& writer);
+
+    // Печатает массив ответов на stat_requests; каждый ответ выводится в
+    // output, как только он готов. Запросы разбираются по одному перед
+    // ответом, так что дерево всего раздела не строится
+    void WriteStatRequests(const json::LazyNode& stat_requests,
+                           const transport::TransportCatalogue& catalogue,
+                           const render::MapRenderer& renderer,
+                           const transport_router::TransportRouter& router,
+                           std::ostream& output);
+
+    // Запрос Update режима serve: публикует следующую версию справочника с
+    // его base_requests и пишет сводку её изменений. Возвращает false, не
+    // публикуя версию, если это не Update или в нём нет id и base_requests
+    bool WriteUpdateResponse(const json::Dict& request,
+                             transport::VersionedCatalogue& versions,
+                             json::Writer& writer);
 }// namespace output
 
 namespace render_config {
@@ -30,11 +172,7 @@ namespace render_config {
     svg::Color ParseColor(const json::Node& node);
 
 template <typename T>
-std::optional<T> GetIf(const json::Dict& dict, const std::string& key) {
-    auto it = dict.find(key);
-    if (it == dict.end()) return std::nullopt;
-
-    const auto& node = it->second;
+std::optional<T> GetIf(const json::Node& node) {
     return std::visit([](const auto& value) -> std::optional<T> {
         using U = std::decay_t<decltype(value)>;
         if constexpr (std::is_same_v<U, T>) {
@@ -46,7 +184,17 @@ std::optional<T> GetIf(const json::Dict& dict, const std::string& key) {
         }
     }, node.GetValue());
 }
+
+template <typename T>
+std::optional<T> GetIf(const json::Dict& dict, const std::string& key) {
+    auto it = dict.find(key);
+    if (it == dict.end()) return std::nullopt;
+    return GetIf<T>(it->second);
+}
 }// namespace render_config
 namespace routing_config {
   transport_router::RoutingSettings ParseRoutingSettings(const json::Dict& settings_json);
 } // namespace routing_config
+namespace serialization_config {
+  serialization::SerializationSettings ParseSerializationSettings(const json::Dict& settings_json);
+} // namespace serialization_config
@@ -0,0 +1,241 @@
+#include "json_scanner.h"
+//json_scanner.cpp
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace json {
+namespace {
+
+constexpr size_t BLOCK = 64;
+// Сколько байт текста индексируется за раз; кратно BLOCK
+constexpr size_t WINDOW = 64 * 1024;
+constexpr uint64_t ODD_BITS = 0xAAAAAAAAAAAAAAAAull;
+
+// Бит i — свойство байта i блока
+struct Masks {
+    uint64_t quote;
+    uint64_t backslash;
+    // Пробел, \t, \n, \v, \f, \r
+    uint64_t space;
+    // { } [ ] : ,
+    uint64_t structural;
+    // \n, \r
+    uint64_t newline;
+};
+
+#if defined(__AVX2__)
+
+uint64_t Equal(__m256i lo, __m256i hi, char c) {
+    const __m256i value = _mm256_set1_epi8(c);
+    const uint32_t lo_bits = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, value));
+    const uint32_t hi_bits = _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, value));
+    return lo_bits | (uint64_t{hi_bits} << 32);
+}
+
+// Байты от 9 (\t) до 13 (\r): c - 9 без знака не больше 4
+uint64_t ControlSpace(__m256i lo, __m256i hi) {
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i four = _mm256_set1_epi8(4);
+    const __m256i lo_shifted = _mm256_sub_epi8(lo, nine);
+    const __m256i hi_shifted = _mm256_sub_epi8(hi, nine);
+    const uint32_t lo_bits = _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_min_epu8(lo_shifted, four), lo_shifted));
+    const uint32_t hi_bits = _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_min_epu8(hi_shifted, four), hi_shifted));
+    return lo_bits | (uint64_t{hi_bits} << 32);
+}
+
+Masks Classify(const char* block) {
+    const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    Masks masks;
+    masks.quote = Equal(lo, hi, '"');
+    masks.backslash = Equal(lo, hi, '\\');
+    masks.newline = Equal(lo, hi, '\n') | Equal(lo, hi, '\r');
+    masks.space = Equal(lo, hi, ' ') | ControlSpace(lo, hi);
+    masks.structural = Equal(lo, hi, '{') | Equal(lo, hi, '}') | Equal(lo, hi, '[')
+                     | Equal(lo, hi, ']') | Equal(lo, hi, ':') | Equal(lo, hi, ',');
+    return masks;
+}
+
+#elif defined(__SSE2__)
+
+uint64_t Equal(const __m128i (&chunks)[4], char c) {
+    const __m128i value = _mm_set1_epi8(c);
+    uint64_t bits = 0;
+    for (int i = 0; i < 4; ++i) {
+        bits |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunks[i], value)))} << (16 * i);
+    }
+    return bits;
+}
+
+// Байты от 9 (\t) до 13 (\r): c - 9 без знака не больше 4
+uint64_t ControlSpace(const __m128i (&chunks)[4]) {
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i four = _mm_set1_epi8(4);
+    uint64_t bits = 0;
+    for (int i = 0; i < 4; ++i) {
+        const __m128i shifted = _mm_sub_epi8(chunks[i], nine);
+        const __m128i in_range = _mm_cmpeq_epi8(_mm_min_epu8(shifted, four), shifted);
+        bits |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(in_range))} << (16 * i);
+    }
+    return bits;
+}
+
+Masks Classify(const char* block) {
+    __m128i chunks[4];
+    for (int i = 0; i < 4; ++i) {
+        chunks[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+    }
+    Masks masks;
+    masks.quote = Equal(chunks, '"');
+    masks.backslash = Equal(chunks, '\\');
+    masks.newline = Equal(chunks, '\n') | Equal(chunks, '\r');
+    masks.space = Equal(chunks, ' ') | ControlSpace(chunks);
+    masks.structural = Equal(chunks, '{') | Equal(chunks, '}') | Equal(chunks, '[')
+                     | Equal(chunks, ']') | Equal(chunks, ':') | Equal(chunks, ',');
+    return masks;
+}
+
+#else
+
+Masks Classify(const char* block) {
+    Masks masks{};
+    for (size_t i = 0; i < BLOCK; ++i) {
+        const uint64_t bit = uint64_t{1} << i;
+        switch (block[i]) {
+            case '"':
+                masks.quote |= bit;
+                break;
+            case '\\':
+                masks.backslash |= bit;
+                break;
+            case '\n':
+            case '\r':
+                masks.newline |= bit;
+                masks.space |= bit;
+                break;
+            case ' ':
+            case '\t':
+            case '\v':
+            case '\f':
+                masks.space |= bit;
+                break;
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',':
+                masks.structural |= bit;
+                break;
+            default:
+                break;
+        }
+    }
+    return masks;
+}
+
+#endif
+
+// Бит i результата — XOR битов 0..i: единицы от открывающей кавычки до
+// закрывающей (не включая её)
+uint64_t PrefixXor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// Байты, экранированные предшествующей обратной косой чертой.
+// escaped_first — первый байт блока экранирован концом предыдущего.
+// В серии из n черт экранирующими являются 1-я, 3-я, ... от её начала;
+// вычитание из маски нечётных позиций раскладывает серии по чётности начала
+uint64_t FindEscaped(uint64_t backslash, uint64_t& escaped_first) {
+    const uint64_t potential_escape = backslash & ~escaped_first;
+    const uint64_t maybe_escaped = potential_escape << 1;
+    const uint64_t escape_and_terminal = ((maybe_escaped | ODD_BITS) - potential_escape) ^ ODD_BITS;
+    const uint64_t escaped = escape_and_terminal ^ (backslash | escaped_first);
+    const uint64_t escape = escape_and_terminal & backslash;
+    escaped_first = escape >> 63;
+    return escaped;
+}
+
+}  // namespace
+
+StructuralScanner::StructuralScanner(std::string_view text)
+    : text_(text) {
+    // Отметок не больше, чем байт: короткому тексту полное окно не нужно
+    positions_.reserve(std::min(WINDOW, text.size()));
+}
+
+const char* StructuralScanner::NextWindow(const char* from) {
+    while (scanned_ < text_.size()) {
+        ScanWindow();
+        for (; cursor_ < positions_.size(); ++cursor_) {
+            const char* mark = window_ + positions_[cursor_];
+            if (mark >= from) {
+                return mark;
+            }
+        }
+    }
+    return text_.data() + text_.size();
+}
+
+void StructuralScanner::ScanWindow() {
+    positions_.clear();
+    cursor_ = 0;
+    window_ = text_.data() + scanned_;
+    const size_t window_offset = scanned_;
+    const size_t end = std::min(scanned_ + WINDOW, text_.size());
+
+    size_t pos = scanned_;
+    for (; pos + BLOCK <= end; pos += BLOCK) {
+        ScanBlock(text_.data() + pos, pos - window_offset);
+    }
+    if (pos < end) {
+        // Хвост дополняется пробелами: они ничего не отмечают
+        char block[BLOCK];
+        std::memset(block, ' ', BLOCK);
+        std::memcpy(block, text_.data() + pos, end - pos);
+        ScanBlock(block, pos - window_offset);
+        while (!positions_.empty() && window_offset + positions_.back() >= end) {
+            positions_.pop_back();
+        }
+    }
+    scanned_ = end;
+}
+
+void StructuralScanner::ScanBlock(const char* block, size_t offset) {
+    const Masks masks = Classify(block);
+
+    const uint64_t quote = masks.quote & ~FindEscaped(masks.backslash, carry_.escaped_next);
+    // Открывающая кавычка и содержимое строки; закрывающая кавычка — снаружи
+    const uint64_t in_string = PrefixXor(quote) ^ carry_.in_string;
+    carry_.in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+    const uint64_t outside = ~in_string & ~quote;
+
+    // Начало числа или литерала: непробельный байт вне строк после пробела,
+    // структурного символа или кавычки
+    const uint64_t boundary = masks.space | masks.structural | quote;
+    const uint64_t after_boundary = (boundary << 1) | carry_.boundary;
+    carry_.boundary = boundary >> 63;
+    const uint64_t scalar_starts = outside & after_boundary & ~boundary;
+
+    uint64_t marks = (masks.structural & outside) | quote
+                   | ((masks.backslash | masks.newline) & in_string) | scalar_starts;
+    while (marks != 0) {
+        positions_.push_back(static_cast<uint32_t>(offset + std::countr_zero(marks)));
+        marks &= marks - 1;
+    }
+}
+
+}  // namespace json
@@ -0,0 +1,61 @@
+#pragma once
+//json_scanner.h
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+// Первый этап разбора в духе simdjson: текст классифицируется блоками по
+// 64 байта (AVX2 или SSE2, если собраны с их поддержкой, иначе побайтово),
+// и по битовым маскам отмечаются позиции, с которых разбор продолжается:
+//   вне строк — { } [ ] : , кавычка, открывающая строку, и первый символ
+//   каждой последовательности непробельных символов (числа, литералы);
+//   внутри строк — закрывающая кавычка, \ и переводы строки.
+// Экранированные кавычки определяются по чётности серий обратных косых черт.
+// Индекс строится окнами по мере продвижения разбора, поэтому его размер
+// не зависит от размера текста
+class StructuralScanner {
+public:
+    explicit StructuralScanner(std::string_view text);
+
+    // Первая отмеченная позиция не раньше from или конец текста.
+    // from не должен уменьшаться больше чем до последней возвращённой позиции
+    const char* Next(const char* from) {
+        while (cursor_ < positions_.size()) {
+            const char* mark = window_ + positions_[cursor_];
+            if (mark >= from) {
+                return mark;
+            }
+            ++cursor_;
+        }
+        return NextWindow(from);
+    }
+
+private:
+    // Состояние между блоками
+    struct Carry {
+        // Первый байт блока экранирован последней чертой предыдущего
+        uint64_t escaped_next = 0;
+        // Все единицы, если предыдущий блок закончился внутри строки
+        uint64_t in_string = 0;
+        // Предыдущий байт — пробел, структурный символ или кавычка
+        uint64_t boundary = 1;
+    };
+
+    // Индексирует следующие окна, пока в них не найдётся позиция не раньше from
+    const char* NextWindow(const char* from);
+    void ScanWindow();
+    void ScanBlock(const char* block, size_t offset);
+
+    std::string_view text_;
+    size_t scanned_ = 0;
+    Carry carry_;
+    std::vector<uint32_t> positions_;
+    // Начало текущего окна; positions_ отсчитываются от него
+    const char* window_ = nullptr;
+    size_t cursor_ = 0;
+};
+
+}  // namespace json
@@ -3,34 +3,166 @@
 #include "json_reader.h"
 #include "map_renderer.h"
 #include "transport_router.h"
+#include "catalogue_version.h"
+#include "serialization.h"
 
-int main() {
-  using namespace std;
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
 
-  const json::Document doc = json::Load(cin);
-  const auto& root = doc.GetRoot().AsDict();
+using namespace std::literals;
 
-  transport::TransportCatalogue catalogue = input::ReadTransportCatalogue(doc);
+namespace {
 
-  render::RenderSettings settings;
-  if (auto rs_it = root.find("render_settings");
-      rs_it != root.end() && rs_it->second.IsDict()) {
-      settings = render_config::ParseRenderSettings(rs_it->second.AsDict());
-  }
+void PrintUsage(std::ostream& stream = std::cerr) {
+    stream << "Usage: transport_catalogue [make_base|process_requests|serve <base.json>]\n"sv;
+}
 
-  render::MapRenderer renderer(settings);
+serialization::SerializationSettings GetSerializationSettings(const json::Dict& root) {
+    return serialization_config::ParseSerializationSettings(
+        root.at("serialization_settings").AsDict());
+}
 
-  transport_router::RoutingSettings routing_settings;
-  if (auto rt_it = root.find("routing_settings");
-      rt_it != root.end() && rt_it->second.IsDict()) {
-      routing_settings = routing_config::ParseRoutingSettings(rt_it->second.AsDict());
-  }
+render::RenderSettings GetRenderSettings(const json::Dict& root) {
+    if (auto rs_it = root.find("render_settings");
+        rs_it != root.end() && rs_it->second.IsDict()) {
+        return render_config::ParseRenderSettings(rs_it->second.AsDict());
+    }
+    return {};
+}
+
+transport_router::RoutingSettings GetRoutingSettings(const json::Dict& root) {
+    if (auto rt_it = root.find("routing_settings");
+        rt_it != root.end() && rt_it->second.IsDict()) {
+        return routing_config::ParseRoutingSettings(rt_it->second.AsDict());
+    }
+    return {};
+}
+
+// Отвечает на stat_requests, используя готовый справочник и настройки из doc
+void ProcessRequests(const json::Document& doc, const json::LazyDocument& stat_requests,
+                     const transport::TransportCatalogue& catalogue) {
+    const auto& root = doc.GetRoot().AsDict();
+    render::MapRenderer renderer(GetRenderSettings(root));
+    transport_router::TransportRouter router(catalogue, GetRoutingSettings(root));
+
+    output::WriteStatRequests(stat_requests.GetRoot(), catalogue, renderer, router, std::cout);
+}
+
+// Отвечает на запросы из input, по одному JSON-объекту в строке: ответ на
+// каждый — одна строка компактного JSON, которая выводится сразу.
+// Маршрутизатор строится один раз на все запросы. Запрос Update публикует
+// следующую версию справочника со своими base_requests и маршрутизатором,
+// обновлённым, а не перестроенным целиком, и следующие запросы видят
+// изменения. Каждый запрос отвечает по одной версии, закреплённой на время
+// ответа. Пустые строки
+// пропускаются; на строку, которую не удалось разобрать или на которую
+// нет ответа, выводится null, чтобы ответы не сбивались со строками запросов
+void ServeRequests(const json::Document& doc, transport::TransportCatalogue catalogue,
+                   std::istream& input, std::ostream& output) {
+    const auto& root = doc.GetRoot().AsDict();
+    render::MapRenderer renderer(GetRenderSettings(root));
+    transport::VersionedCatalogue versions(std::move(catalogue), GetRoutingSettings(root));
 
-  transport_router::TransportRouter router(catalogue, routing_settings);
+    json::Writer writer(output, json::PrintOptions{.compact = true});
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.find_first_not_of(" \t\r"sv) == std::string::npos) {
+            continue;
+        }
+        bool answered = false;
+        try {
+            const json::Document request = json::Load(line);
+            const transport::CatalogueVersionPtr version = versions.Pin();
+            answered = request.GetRoot().IsDict()
+                       && (output::WriteUpdateResponse(request.GetRoot().AsDict(), versions, writer)
+                           || output::WriteStatResponse(request.GetRoot().AsDict(), version->Catalogue(), renderer,
+                                                        version->Router(), writer));
+        } catch (const std::exception&) {
+            // Ответ пишется только после всех проверок, поэтому в буфере
+            // от неудачного запроса ничего не остаётся
+        }
+        if (!answered) {
+            writer.Value(nullptr);
+        }
+        writer.Flush();
+        output.put('\n');
+        output.flush();
+    }
+}
+
+int Serve(const char* base_path) {
+    std::ifstream base(base_path, std::ios::binary);
+    if (!base) {
+        std::cerr << "Cannot open "sv << base_path << '\n';
+        return 1;
+    }
+    input::DocumentReader reader(true);
+    reader.SkipSection("stat_requests"s);
+    json::Parse(base, reader);
+    const json::Document doc = reader.ExtractDocument();
+    transport::TransportCatalogue catalogue = reader.ExtractCatalogue();
+
+    // Построчное чтение из cin, синхронизированного с stdio, идёт посимвольно
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+    ServeRequests(doc, std::move(catalogue), std::cin, std::cout);
+    return 0;
+}
 
-  const auto stat = output::ReadStatRequests(doc, catalogue, renderer, router);
+}  // namespace
 
-  json::Print(json::Document(json::Node(std::move(stat.responses))), std::cout);
+// Без аргументов программа строит справочник из base_requests и сразу отвечает
+// на stat_requests. Режим make_base сохраняет справочник в бинарный файл из
+// serialization_settings, а process_requests загружает его оттуда, не разбирая
+// base_requests заново. Режим serve строит справочник из документа в файле и
+// затем отвечает на запросы из стандартного ввода, по одному в строке;
+// запросы Update вносят в него изменения.
+int main(int argc, char* argv[]) {
+  using namespace std;
+
+  const std::string_view mode = argc >= 2 ? std::string_view(argv[1]) : ""sv;
+  if (mode == "serve"sv) {
+      if (argc != 3) {
+          PrintUsage();
+          return 1;
+      }
+      return Serve(argv[2]);
+  }
+  if (argc > 2 || (!mode.empty() && mode != "make_base"sv && mode != "process_requests"sv)) {
+      PrintUsage();
+      return 1;
+  }
+
+  // base_requests загружаются в справочник по мере разбора, без дерева всего документа.
+  // Разделы, не нужные режиму, пропускаются без разбора, а stat_requests
+  // разбираются по одному запросу, когда до него доходит очередь
+  input::DocumentReader reader(mode != "process_requests"sv);
+  if (mode == "make_base"sv) {
+      reader.SkipSection("render_settings"s);
+      reader.SkipSection("routing_settings"s);
+      reader.SkipSection("stat_requests"s);
+  } else {
+      reader.DeferSection("stat_requests"s);
+  }
+  json::Parse(cin, reader);
+  const json::Document doc = reader.ExtractDocument();
+  const json::LazyDocument stat_requests = reader.ExtractDeferredSection("stat_requests"sv);
+  const auto& root = doc.GetRoot().AsDict();
+
+  if (mode == "make_base"sv) {
+      const transport::TransportCatalogue catalogue = reader.ExtractCatalogue();
+      serialization::SaveCatalogue(catalogue, GetSerializationSettings(root).file);
+  } else if (mode == "process_requests"sv) {
+      const transport::TransportCatalogue catalogue =
+          serialization::LoadCatalogue(GetSerializationSettings(root).file);
+      ProcessRequests(doc, stat_requests, catalogue);
+  } else {
+      const transport::TransportCatalogue catalogue = reader.ExtractCatalogue();
+      ProcessRequests(doc, stat_requests, catalogue);
+  }
 
   return 0;
 }
@@ -11,7 +11,7 @@ namespace render
         svg::Document doc;
 
         std::unordered_set<const transport::Stop*> used_stops;
-        std::deque<const transport::Bus*> buses = catalogue.GetAllBuses();
+        const std::vector<const transport::Bus*>& buses = catalogue.GetBusesSortedByName();
         for (const transport::Bus* bus : buses){
             for (const transport::Stop* stop :bus->stops){
                 used_stops.insert(stop);
@@ -20,17 +20,13 @@ namespace render
         std::vector<geo::Coordinates> geo_coords;
         geo_coords.reserve(used_stops.size());
         for (const transport::Stop* stop : used_stops) {
-            geo_coords.push_back(stop->coordinates);
+            geo_coords.push_back(geo::ToDegrees(stop->coordinates));
         }
 
         SphereProjector projector(geo_coords.begin(),geo_coords.end(),
                                   settings_.width,settings_.height,settings_.padding
                                  );
 
-        std::sort(buses.begin(),buses.end(),[](const transport::Bus* lhs,
-                                               const transport::Bus* rhs){
-            return lhs ->name < rhs -> name;
-        });
       RenderBusLines(doc, buses, projector);       // 1. маршруты
       RenderBusLabels(doc, buses, projector);      // 2. подписи маршрутов
       RenderStopPoints(doc, used_stops, projector); // 3. кружки остановок
@@ -39,13 +35,13 @@ namespace render
       return doc;
 
     }
-    void MapRenderer::RenderBusLines(svg::Document& doc,const std::deque<const transport::Bus*>& buses, const SphereProjector& projector) const {
+    void MapRenderer::RenderBusLines(svg::Document& doc,const std::vector<const transport::Bus*>& buses, const SphereProjector& projector) const {
 
             size_t color_index =0;
             for (const transport::Bus* bus : buses){
                 if (bus ->stops.empty()) continue;
                 svg::Polyline line;
-                for (const transport::Stop* stop: bus->stops){
+                for (const transport::Stop* stop: bus->Route()){
                     line.AddPoint(projector(stop->coordinates));
                 }
                 line.SetStrokeColor(settings_.color_palette[color_index % settings_.color_palette.size()])
@@ -59,7 +55,7 @@ namespace render
             }
         }
 
-    void MapRenderer::RenderBusLabels(svg::Document& doc,const std::deque<const transport::Bus*>& buses, const SphereProjector& projector) const{
+    void MapRenderer::RenderBusLabels(svg::Document& doc,const std::vector<const transport::Bus*>& buses, const SphereProjector& projector) const{
 
             size_t color_index =0;
             for (const transport::Bus* bus:buses){
@@ -71,8 +67,8 @@ namespace render
                 RenderTextLayer(doc, bus->name, pos, color, false, TextType::Bus);
 
            if (!bus->is_roundtrip && bus->stops.size() >= 2) {
-    size_t mid = bus->stops.size() / 2;
-    const transport::Stop* mid_stop = bus->stops[mid];
+    // Конечная некольцевого маршрута — последняя из хранимых остановок
+    const transport::Stop* mid_stop = bus->stops.back();
 
     // Проверим, чтобы не дублировать начало маршрута
     if (mid_stop != bus->stops.front()) {
@@ -120,11 +116,11 @@ namespace render
         }
     }
 
-    void MapRenderer::RenderTextLayer(svg::Document& doc, const std::string& text,
+    void MapRenderer::RenderTextLayer(svg::Document& doc, std::string_view text,
                                     svg::Point pos, svg::Color color,
                                     bool underlayer, TextType type) const {
         svg::Text txt;
-        txt.SetData(text)
+        txt.SetData(std::string(text))
         .SetPosition(pos)
         .SetOffset(type == TextType::Bus ? settings_.bus_label_offset : settings_.stop_label_offset)
         .SetFontSize(type == TextType::Bus ? settings_.bus_label_font_size : settings_.stop_label_font_size)
@@ -7,6 +7,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <optional>
+#include <string_view>
 #include <vector>
 
 inline const double EPSILON = 1e-6;
@@ -42,6 +43,7 @@ namespace render
                         double max_width, double max_height, double padding);
 
         svg::Point operator()(geo::Coordinates coords) const ;
+        svg::Point operator()(geo::MicroCoordinates coords) const ;
 
     private:
         double padding_;
@@ -60,11 +62,11 @@ namespace render
             RenderSettings settings_;
 
             void RenderBusLines(svg::Document& doc,
-                                const std::deque<const transport::Bus*>& buses,
+                                const std::vector<const transport::Bus*>& buses,
                                 const SphereProjector& projector) const;
 
             void RenderBusLabels(svg::Document& doc,
-                                const std::deque<const transport::Bus*>& buses,
+                                const std::vector<const transport::Bus*>& buses,
                                 const SphereProjector& projector) const;
 
             void RenderStopPoints(svg::Document& doc,
@@ -75,7 +77,7 @@ namespace render
                                   const std::unordered_set<const transport::Stop*>& stops,
                                   const SphereProjector& projector) const;
 
-            void RenderTextLayer(svg::Document& doc, const std::string& text,
+            void RenderTextLayer(svg::Document& doc, std::string_view text,
                                   svg::Point pos, svg::Color color,
                                   bool underlayer, TextType type) const;
 
@@ -136,6 +138,9 @@ namespace render
                 (max_lat_ - coords.lat) * zoom_coeff_ + padding_
             };
         }
+        inline svg::Point SphereProjector::operator()(geo::MicroCoordinates coords) const {
+            return (*this)(geo::ToDegrees(coords));
+        }
 
 } // namespace render
 
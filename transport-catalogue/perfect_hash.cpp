@@ -0,0 +1,177 @@
+#include "perfect_hash.h"
+//perfect_hash.cpp
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace perfect_hash {
+namespace {
+
+constexpr uint64_t GOLDEN = 0x9E3779B97F4A7C15ull;
+constexpr uint64_t SLOT_MULTIPLIER = 0xD6E8FEB86659FD93ull;
+// Сколько смещений перебираем для одной корзины, прежде чем сменить seed
+constexpr uint32_t MAX_PILOT = 1u << 22;
+constexpr int MAX_ATTEMPTS = 8;
+
+uint64_t Mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t RotateLeft(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+}  // namespace
+
+StringIndex::StringIndex(const std::vector<std::string_view>& keys)
+    : StringIndex(keys, std::vector<uint32_t>{}) {
+}
+
+StringIndex::StringIndex(const std::vector<std::string_view>& keys, const std::vector<uint32_t>& positions) {
+    if (!positions.empty() && positions.size() != keys.size()) {
+        throw std::invalid_argument("Perfect hash positions do not match the keys");
+    }
+    for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+        if (TryBuild(keys, positions, Mix(GOLDEN * (attempt + 1)))) {
+            return;
+        }
+    }
+    throw std::runtime_error("Failed to build perfect hash");
+}
+
+StringIndex::StringIndex(const std::vector<std::string_view>& keys_by_position, const Tables& tables)
+    : seed_(tables.seed)
+    , pilots_(tables.pilots.begin(), tables.pilots.end())
+    , positions_(tables.positions.begin(), tables.positions.end()) {
+    if (pilots_.size() != std::max<size_t>(1, (positions_.size() + 3) / 4)) {
+        throw std::invalid_argument("Perfect hash tables do not match the keys");
+    }
+    keys_.reserve(positions_.size());
+    for (uint32_t position : positions_) {
+        if (position >= keys_by_position.size()) {
+            throw std::invalid_argument("Perfect hash tables do not match the keys");
+        }
+        keys_.push_back(keys_by_position[position]);
+    }
+}
+
+uint64_t StringIndex::Hash(std::string_view key) const {
+    uint64_t h = seed_ ^ (key.size() * GOLDEN);
+    const char* data = key.data();
+    size_t len = key.size();
+    while (len >= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        h = RotateLeft(h ^ (word * GOLDEN), 31) * GOLDEN;
+        data += 8;
+        len -= 8;
+    }
+    if (len > 0) {
+        uint64_t word = 0;
+        std::memcpy(&word, data, len);
+        h = RotateLeft(h ^ (word * GOLDEN), 31) * GOLDEN;
+    }
+    return Mix(h);
+}
+
+size_t StringIndex::Bucket(uint64_t hash) const {
+    return static_cast<size_t>(((hash >> 32) * pilots_.size()) >> 32);
+}
+
+// Ячейка — старшие биты произведения, приведённые к размеру таблицы
+// умножением со сдвигом вместо деления по модулю
+size_t StringIndex::Slot(uint64_t hash, uint32_t pilot) const {
+    const uint64_t mixed = (hash ^ (pilot * GOLDEN)) * SLOT_MULTIPLIER;
+    return static_cast<size_t>(((mixed >> 32) * keys_.size()) >> 32);
+}
+
+bool StringIndex::TryBuild(const std::vector<std::string_view>& keys, std::span<const uint32_t> positions,
+                           uint64_t seed) {
+    const size_t n = keys.size();
+    seed_ = seed;
+    keys_.assign(n, std::string_view{});
+    positions_.assign(n, 0);
+    pilots_.assign(std::max<size_t>(1, (n + 3) / 4), 0);
+    if (n == 0) {
+        return true;
+    }
+
+    std::vector<uint64_t> hashes(n);
+    std::vector<std::vector<uint32_t>> buckets(pilots_.size());
+    for (size_t i = 0; i < n; ++i) {
+        hashes[i] = Hash(keys[i]);
+        buckets[Bucket(hashes[i])].push_back(static_cast<uint32_t>(i));
+    }
+
+    // Сначала размещаем крупные корзины, пока таблица почти пуста
+    std::vector<size_t> order(buckets.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&buckets](size_t lhs, size_t rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+
+    // Одинаковые ключи всегда попадают в одну корзину с одинаковым хешем,
+    // и ни одно смещение их не разведёт: проверяем сразу, а не перебором
+    for (const auto& members : buckets) {
+        for (size_t i = 0; i < members.size(); ++i) {
+            for (size_t j = i + 1; j < members.size(); ++j) {
+                if (hashes[members[i]] == hashes[members[j]] && keys[members[i]] == keys[members[j]]) {
+                    throw std::invalid_argument("Duplicate key in perfect hash");
+                }
+            }
+        }
+    }
+
+    std::vector<bool> taken(n, false);
+    std::vector<size_t> slots;
+    for (size_t bucket : order) {
+        const auto& members = buckets[bucket];
+        if (members.empty()) {
+            break;
+        }
+
+        bool placed = false;
+        for (uint32_t pilot = 0; pilot < MAX_PILOT && !placed; ++pilot) {
+            slots.clear();
+            placed = true;
+            for (uint32_t key_id : members) {
+                const size_t slot = Slot(hashes[key_id], pilot);
+                if (taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                    placed = false;
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (placed) {
+                pilots_[bucket] = pilot;
+            }
+        }
+        if (!placed) {
+            return false;
+        }
+
+        for (size_t i = 0; i < members.size(); ++i) {
+            taken[slots[i]] = true;
+            keys_[slots[i]] = keys[members[i]];
+            positions_[slots[i]] = positions.empty() ? members[i] : positions[members[i]];
+        }
+    }
+    return true;
+}
+
+size_t StringIndex::Find(std::string_view key) const {
+    if (keys_.empty()) {
+        return npos;
+    }
+    const uint64_t hash = Hash(key);
+    const size_t slot = Slot(hash, pilots_[Bucket(hash)]);
+    return keys_[slot] == key ? positions_[slot] : npos;
+}
+
+}  // namespace perfect_hash
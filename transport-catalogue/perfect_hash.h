@@ -0,0 +1,147 @@
+#pragma once
+//perfect_hash.h
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace perfect_hash {
+
+// Минимальная совершенная хеш-функция над фиксированным набором строк
+// (схема "hash and displace"). Ключи разбиваются на корзины, и для каждой
+// корзины подбирается смещение (pilot), при котором все её ключи попадают
+// в свободные ячейки таблицы размера ровно keys.size().
+// Поиск: хеш строки (проход по 8 байт и финальное перемешивание), номер
+// корзины умножением со сдвигом, ячейка — xor со смещением корзины,
+// одно умножение и ещё одно умножение со сдвигом. Из памяти читаются
+// смещение корзины, ключ в ячейке и его позиция; затем одно сравнение строк.
+// Строки не копируются: индекс хранит string_view, поэтому данные ключей
+// должны жить не меньше самого индекса.
+class StringIndex {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    // Таблицы построенного индекса. По ним индекс восстанавливается без
+    // подбора смещений (например, из файла)
+    struct Tables {
+        uint64_t seed = 0;
+        std::span<const uint32_t> pilots;
+        // Ячейка таблицы -> позиция ключа (то, что возвращает Find)
+        std::span<const uint32_t> positions;
+    };
+
+    StringIndex() = default;
+    // Ключи должны быть попарно различны, иначе бросается std::invalid_argument
+    explicit StringIndex(const std::vector<std::string_view>& keys);
+    // То же, но позицией ключа keys[i] считается positions[i]
+    StringIndex(const std::vector<std::string_view>& keys, const std::vector<uint32_t>& positions);
+    // Восстанавливает индекс по таблицам; keys_by_position[p] — ключ с позицией p.
+    // Если таблицы не подходят к ключам, бросается std::invalid_argument
+    StringIndex(const std::vector<std::string_view>& keys_by_position, const Tables& tables);
+
+    // Возвращает позицию ключа в исходном векторе keys или npos
+    size_t Find(std::string_view key) const;
+
+    size_t Size() const {
+        return keys_.size();
+    }
+
+    // Таблицы ссылаются на память индекса
+    Tables GetTables() const {
+        return {seed_, pilots_, positions_};
+    }
+
+private:
+    bool TryBuild(const std::vector<std::string_view>& keys, std::span<const uint32_t> positions, uint64_t seed);
+
+    uint64_t Hash(std::string_view key) const;
+    size_t Bucket(uint64_t hash) const;
+    size_t Slot(uint64_t hash, uint32_t pilot) const;
+
+    uint64_t seed_ = 0;
+    std::vector<uint32_t> pilots_;
+    // Ячейка таблицы -> ключ и его позиция
+    std::vector<std::string_view> keys_;
+    std::vector<uint32_t> positions_;
+};
+
+// Ключ и значение для StaticStringIndex
+template <typename Value>
+struct StaticEntry {
+    std::string_view key;
+    Value value;
+};
+
+// Совершенная хеш-функция над набором строк, известным при компиляции.
+// Подбирается seed, при котором ключи не сталкиваются в таблице размера
+// bit_ceil(2 * N). Таблица строится в consteval-конструкторе, поэтому набор
+// с повторами или пустыми ключами не компилируется. Поиск: побайтовое
+// хеширование короткого ключа, одно обращение к таблице и одно сравнение строк
+template <typename Value, size_t N>
+class StaticStringIndex {
+public:
+    consteval explicit StaticStringIndex(const std::array<StaticEntry<Value>, N>& entries)
+        : entries_(entries) {
+        for (const auto& entry : entries_) {
+            // Пустой ключ остаётся от недописанного массива
+            if (entry.key.empty()) {
+                throw std::invalid_argument("Empty key in static index");
+            }
+        }
+        for (uint64_t seed = 0; seed < MAX_SEED; ++seed) {
+            if (TryBuild(seed)) {
+                return;
+            }
+        }
+        throw std::invalid_argument("Failed to build perfect hash: keys must be unique");
+    }
+
+    constexpr std::optional<Value> Find(std::string_view key) const {
+        const uint8_t index = slots_[Slot(key, seed_)];
+        if (index < N && entries_[index].key == key) {
+            return entries_[index].value;
+        }
+        return std::nullopt;
+    }
+
+private:
+    static constexpr size_t TABLE_SIZE = std::bit_ceil(2 * N);
+    static constexpr uint64_t MAX_SEED = 1u << 16;
+    static constexpr uint8_t EMPTY = 0xFF;
+    static_assert(N < EMPTY, "too many keys for a static index");
+
+    static constexpr size_t Slot(std::string_view key, uint64_t seed) {
+        uint64_t h = 0xCBF29CE484222325ull ^ (seed * 0x9E3779B97F4A7C15ull);
+        for (char c : key) {
+            h = (h ^ static_cast<uint8_t>(c)) * 0x100000001B3ull;
+        }
+        h ^= h >> 29;
+        return static_cast<size_t>(h & (TABLE_SIZE - 1));
+    }
+
+    constexpr bool TryBuild(uint64_t seed) {
+        slots_.fill(EMPTY);
+        for (size_t i = 0; i < N; ++i) {
+            uint8_t& slot = slots_[Slot(entries_[i].key, seed)];
+            if (slot != EMPTY) {
+                if (entries_[slot].key == entries_[i].key) {
+                    throw std::invalid_argument("Duplicate key in static index");
+                }
+                return false;
+            }
+            slot = static_cast<uint8_t>(i);
+        }
+        seed_ = seed;
+        return true;
+    }
+
+    std::array<StaticEntry<Value>, N> entries_;
+    std::array<uint8_t, TABLE_SIZE> slots_{};
+    uint64_t seed_ = 0;
+};
+
+}  // namespace perfect_hash
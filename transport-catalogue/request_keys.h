@@ -0,0 +1,160 @@
+#pragma once
+//request_keys.h
+#include "json.h"
+#include "json_flat.h"
+#include "perfect_hash.h"
+
+#include <array>
+#include <cstdint>
+#include <ranges>
+#include <stdexcept>
+#include <string_view>
+
+namespace request_keys {
+
+// Ключи, которые читают разборщики запросов и настроек
+enum class Key : uint8_t {
+    // запросы
+    Id,
+    Type,
+    Name,
+    Latitude,
+    Longitude,
+    RoadDistances,
+    Stops,
+    IsRoundtrip,
+    From,
+    To,
+    Count,
+    Radius,
+    Prefix,
+    PerBus,
+    BaseRequests,
+    // render_settings
+    Width,
+    Height,
+    Padding,
+    LineWidth,
+    StopRadius,
+    BusLabelFontSize,
+    BusLabelOffset,
+    StopLabelFontSize,
+    StopLabelOffset,
+    UnderlayerColor,
+    UnderlayerWidth,
+    ColorPalette,
+
+    Unknown
+};
+
+enum class RequestType : uint8_t {
+    Stop,
+    Bus,
+    Route,
+    Nearby,
+    CommonBuses,
+    Search,
+    NetworkStats,
+    Map,
+    Update,
+
+    Unknown
+};
+
+// Размер таблиц — число значений перечисления: пропущенное значение оставит
+// пустой ключ, и таблица не скомпилируется
+inline constexpr perfect_hash::StaticStringIndex KEY_INDEX{std::array<perfect_hash::StaticEntry<Key>, static_cast<size_t>(Key::Unknown)>{{
+    {"id", Key::Id},
+    {"type", Key::Type},
+    {"name", Key::Name},
+    {"latitude", Key::Latitude},
+    {"longitude", Key::Longitude},
+    {"road_distances", Key::RoadDistances},
+    {"stops", Key::Stops},
+    {"is_roundtrip", Key::IsRoundtrip},
+    {"from", Key::From},
+    {"to", Key::To},
+    {"count", Key::Count},
+    {"radius", Key::Radius},
+    {"prefix", Key::Prefix},
+    {"per_bus", Key::PerBus},
+    {"base_requests", Key::BaseRequests},
+    {"width", Key::Width},
+    {"height", Key::Height},
+    {"padding", Key::Padding},
+    {"line_width", Key::LineWidth},
+    {"stop_radius", Key::StopRadius},
+    {"bus_label_font_size", Key::BusLabelFontSize},
+    {"bus_label_offset", Key::BusLabelOffset},
+    {"stop_label_font_size", Key::StopLabelFontSize},
+    {"stop_label_offset", Key::StopLabelOffset},
+    {"underlayer_color", Key::UnderlayerColor},
+    {"underlayer_width", Key::UnderlayerWidth},
+    {"color_palette", Key::ColorPalette},
+}}};
+
+inline constexpr perfect_hash::StaticStringIndex TYPE_INDEX{std::array<perfect_hash::StaticEntry<RequestType>, static_cast<size_t>(RequestType::Unknown)>{{
+    {"Stop", RequestType::Stop},
+    {"Bus", RequestType::Bus},
+    {"Route", RequestType::Route},
+    {"Nearby", RequestType::Nearby},
+    {"CommonBuses", RequestType::CommonBuses},
+    {"Search", RequestType::Search},
+    {"NetworkStats", RequestType::NetworkStats},
+    {"Map", RequestType::Map},
+    {"Update", RequestType::Update},
+}}};
+
+constexpr Key ToKey(std::string_view key) {
+    return KEY_INDEX.Find(key).value_or(Key::Unknown);
+}
+
+constexpr RequestType ToRequestType(std::string_view type) {
+    return TYPE_INDEX.Find(type).value_or(RequestType::Unknown);
+}
+
+static_assert(ToKey("color_palette") == Key::ColorPalette && ToKey("Type") == Key::Unknown);
+static_assert(ToRequestType("Map") == RequestType::Map && ToRequestType("map") == RequestType::Unknown);
+
+// Значения известных ключей словаря, собранные за один проход по нему:
+// дальше поле находится по индексу, без поиска по строке. Неизвестные
+// ключи пропускаются. Node — json::Node для словаря json::Dict или
+// json::FlatNode для элементов FlatNode::AsDict()
+template <typename Node>
+class BasicFields {
+public:
+    template <std::ranges::range Members>
+    explicit BasicFields(const Members& members) {
+        for (const auto& [key, value] : members) {
+            if (const Key known = ToKey(key); known != Key::Unknown) {
+                values_[static_cast<size_t>(known)] = &value;
+            }
+        }
+    }
+
+    // nullptr, если ключа нет
+    const Node* Find(Key key) const {
+        return values_[static_cast<size_t>(key)];
+    }
+
+    const Node& At(Key key) const {
+        if (const Node* value = Find(key)) {
+            return *value;
+        }
+        throw std::out_of_range("Missing request key");
+    }
+
+    // Тип запроса; Unknown, если его нет или он не строка
+    RequestType GetType() const {
+        const Node* type = Find(Key::Type);
+        return type && type->IsString() ? ToRequestType(type->AsString()) : RequestType::Unknown;
+    }
+
+private:
+    std::array<const Node*, static_cast<size_t>(Key::Unknown)> values_{};
+};
+
+using Fields = BasicFields<json::Node>;
+using FlatFields = BasicFields<json::FlatNode>;
+
+}  // namespace request_keys
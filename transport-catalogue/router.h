@@ -4,9 +4,13 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
 #include <iterator>
+#include <functional>
+#include <memory>
 #include <optional>
+#include <queue>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
@@ -21,6 +25,9 @@ private:
 
 public:
     explicit Router(const Graph& graph);
+    // Маршрутизатор над копией графа other: таблица маршрутов общая с other,
+    // а строка копируется, когда одна из сторон впервые её меняет
+    Router(const Router& other, const Graph& graph);
 
     struct RouteInfo {
         Weight weight;
@@ -29,23 +36,49 @@ public:
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    // Обновляет таблицу маршрутов после изменения графа: removed_edges уже
+    // исключены из графа, а added_edges и новые вершины добавлены в него.
+    // Алгоритмом Дейкстры пересчитываются строки новых вершин, начал новых рёбер
+    // и строки, маршруты которых проходили через удалённые рёбра. Остальные строки
+    // улучшаются только через начала новых рёбер: первое новое ребро на пути
+    // начинается в одной из них, а до неё путь проходит по старым рёбрам.
+    // Итого O(V^2) на каждую вершину-начало вместо O(V^3) на весь граф.
+    // Если пересчитывать пришлось бы почти все строки, таблица строится заново
+    void Update(const std::vector<EdgeId>& removed_edges, const std::vector<EdgeId>& added_edges);
+
+    // Переводит таблицу на новые идентификаторы рёбер после Graph::Compact.
+    // Таблица не должна ссылаться на удалённые рёбра: после Update это так
+    void RemapEdges(const std::vector<EdgeId>& new_edge_ids);
+
 private:
     struct RouteInternalData {
         Weight weight;
         std::optional<EdgeId> prev_edge;
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    using Row = std::vector<std::optional<RouteInternalData>>;
+    // Строки таблицы могут быть общими с копиями маршрутизатора
+    using RoutesInternalData = std::vector<std::shared_ptr<Row>>;
+
+    // Строка, которую маршрутизатор собирается менять: общая сначала копируется
+    Row& MutableRow(VertexId vertex) {
+        auto& row = routes_internal_data_[vertex];
+        if (row.use_count() > 1) {
+            row = std::make_shared<Row>(*row);
+        }
+        return *row;
+    }
 
     void InitializeRoutesInternalData(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+            Row& row = *routes_internal_data_[vertex];
+            row[vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
+                auto& route_internal_data = row[edge.to];
                 if (!route_internal_data || route_internal_data->weight > edge.weight) {
                     route_internal_data = RouteInternalData{edge.weight, edge_id};
                 }
@@ -53,28 +86,77 @@ private:
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
-        }
-    }
-
+    // Строка vertex_from копируется, только если через vertex_through
+    // нашёлся хотя бы один более короткий маршрут
     void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
         for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+            const auto route_from = (*routes_internal_data_[vertex_from])[vertex_through];
+            if (!route_from) {
+                continue;
+            }
+            const Row& row_through = *routes_internal_data_[vertex_through];
+            Row* row_from = routes_internal_data_[vertex_from].get();
+            bool copied = false;
+            for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+                const auto& route_to = row_through[vertex_to];
+                if (!route_to) {
+                    continue;
+                }
+                const Weight candidate_weight = route_from->weight + route_to->weight;
+                const auto& route_relaxing = (*row_from)[vertex_to];
+                if (!route_relaxing || candidate_weight < route_relaxing->weight) {
+                    if (!copied) {
+                        row_from = &MutableRow(vertex_from);
+                        copied = true;
                     }
+                    (*row_from)[vertex_to] = RouteInternalData{
+                        candidate_weight, route_to->prev_edge ? route_to->prev_edge : route_from->prev_edge};
+                }
+            }
+        }
+    }
+
+    void RebuildRow(VertexId vertex_from) {
+        auto& row = MutableRow(vertex_from);
+        std::fill(row.begin(), row.end(), std::nullopt);
+        row[vertex_from] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        queue.push({ZERO_WEIGHT, vertex_from});
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (row[vertex]->weight < weight) {
+                continue;
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                if (edge.weight < ZERO_WEIGHT) {
+                    throw std::domain_error("Edges' weights should be non-negative");
+                }
+                const Weight candidate_weight = weight + edge.weight;
+                auto& route = row[edge.to];
+                if (!route || candidate_weight < route->weight) {
+                    route = RouteInternalData{candidate_weight, edge_id};
+                    queue.push({candidate_weight, edge.to});
                 }
             }
         }
     }
 
+    // Таблица строится в новых строках, не трогая общие с копиями
+    void BuildAllRoutes() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        for (auto& row : routes_internal_data_) {
+            row = std::make_shared<Row>(vertex_count);
+        }
+        InitializeRoutesInternalData(graph_);
+        for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+        }
+    }
+
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
     RoutesInternalData routes_internal_data_;
@@ -83,21 +165,95 @@ private:
 template <typename Weight>
 Router<Weight>::Router(const Graph& graph)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , routes_internal_data_(graph.GetVertexCount())
+{
+    BuildAllRoutes();
+}
+
+template <typename Weight>
+Router<Weight>::Router(const Router& other, const Graph& graph)
+    : graph_(graph)
+    , routes_internal_data_(other.routes_internal_data_)
 {
-    InitializeRoutesInternalData(graph);
+}
+
+template <typename Weight>
+void Router<Weight>::Update(const std::vector<EdgeId>& removed_edges,
+                            const std::vector<EdgeId>& added_edges) {
+    const size_t old_vertex_count = routes_internal_data_.size();
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (vertex_count > old_vertex_count) {
+        for (VertexId vertex = 0; vertex < old_vertex_count; ++vertex) {
+            MutableRow(vertex).resize(vertex_count);
+        }
+        routes_internal_data_.resize(vertex_count);
+        for (VertexId vertex = old_vertex_count; vertex < vertex_count; ++vertex) {
+            routes_internal_data_[vertex] = std::make_shared<Row>(vertex_count);
+        }
+    }
+
+    std::vector<bool> is_removed(graph_.GetEdgeCount(), false);
+    for (const EdgeId edge_id : removed_edges) {
+        is_removed[edge_id] = true;
+    }
+    std::vector<bool> is_source(vertex_count, false);
+    std::vector<VertexId> sources;
+    for (const EdgeId edge_id : added_edges) {
+        const VertexId from = graph_.GetEdge(edge_id).from;
+        if (!is_source[from]) {
+            is_source[from] = true;
+            sources.push_back(from);
+        }
+    }
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+    // Маршрут проходит через ребро тогда и только тогда, когда в той же строке
+    // есть маршрут, для которого это ребро последнее
+    auto uses_removed_edge = [&is_removed](const std::optional<RouteInternalData>& route) {
+        return route && route->prev_edge && is_removed[*route->prev_edge];
+    };
+    std::vector<VertexId> stale_rows;
+    for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+        const Row& row = *routes_internal_data_[vertex_from];
+        if (vertex_from >= old_vertex_count || is_source[vertex_from]
+            || (!removed_edges.empty() && std::any_of(row.begin(), row.end(), uses_removed_edge))) {
+            stale_rows.push_back(vertex_from);
+        }
+    }
+
+    // Дейкстра стоит около E*log(V) на строку, полный пересчёт — V^3
+    const double row_cost = static_cast<double>(graph_.GetEdgeCount() + vertex_count)
+                          * std::log2(static_cast<double>(vertex_count) + 1.0);
+    const double full_cost = static_cast<double>(vertex_count) * vertex_count * vertex_count;
+    if ((stale_rows.size() + sources.size()) * row_cost >= full_cost) {
+        BuildAllRoutes();
+        return;
+    }
+
+    for (const VertexId vertex_from : stale_rows) {
+        RebuildRow(vertex_from);
+    }
+    for (const VertexId vertex_through : sources) {
         RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
     }
 }
 
+template <typename Weight>
+void Router<Weight>::RemapEdges(const std::vector<EdgeId>& new_edge_ids) {
+    for (VertexId vertex = 0; vertex < routes_internal_data_.size(); ++vertex) {
+        for (auto& route : MutableRow(vertex)) {
+            if (route && route->prev_edge) {
+                assert(new_edge_ids[*route->prev_edge] != NO_EDGE);
+                route->prev_edge = new_edge_ids[*route->prev_edge];
+            }
+        }
+    }
+}
+
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
+    const Row& row = *routes_internal_data_.at(from);
+    const auto& route_internal_data = row.at(to);
     if (!route_internal_data) {
         return std::nullopt;
     }
@@ -105,7 +261,7 @@ std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(Ver
     std::vector<EdgeId> edges;
     for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
          edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+         edge_id = row[graph_.GetEdge(*edge_id).from]->prev_edge)
     {
         edges.push_back(*edge_id);
     }
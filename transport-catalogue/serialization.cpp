@@ -0,0 +1,221 @@
+#include "serialization.h"
+//serialization.cpp
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace serialization {
+namespace {
+using namespace std::literals;
+
+using Image = transport::CatalogueImage;
+
+// Секции файла в порядке записи
+enum SectionId {
+    STRINGS,
+    STOPS,
+    BUSES,
+    ROUTE_STOPS,
+    ROAD_PREFIX,
+    DISTANCES,
+    STOPS_BY_NAME,
+    BUSES_BY_NAME,
+    STOP_INDEX_PILOTS,
+    STOP_INDEX_POSITIONS,
+    BUS_INDEX_PILOTS,
+    BUS_INDEX_POSITIONS,
+    STOP_BUS_OFFSETS,
+    STOP_BUS_IDS,
+    GRID_OFFSETS,
+    GRID_STOPS,
+    SECTION_COUNT
+};
+
+struct Section {
+    uint64_t offset;
+    // Число элементов
+    uint64_t count;
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t file_size;
+    uint64_t stop_index_seed;
+    uint64_t bus_index_seed;
+    spatial::StopGrid::Layout grid;
+    Section sections[SECTION_COUNT];
+};
+
+// Записи образа пишутся в файл как есть
+static_assert(std::is_trivially_copyable_v<Image::StopRecord> && sizeof(Image::StopRecord) == 24);
+static_assert(std::is_trivially_copyable_v<Image::BusRecord> && sizeof(Image::BusRecord) == 32);
+static_assert(std::is_trivially_copyable_v<Image::DistanceRecord> && sizeof(Image::DistanceRecord) == 12);
+static_assert(std::is_trivially_copyable_v<spatial::StopGrid::Layout> && sizeof(spatial::StopGrid::Layout) == 48);
+static_assert(sizeof(Header) % 8 == 0);
+
+constexpr uint64_t ALIGNMENT = 8;
+
+uint64_t AlignUp(uint64_t value) {
+    return (value + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+template <typename T>
+void WriteSection(std::ofstream& out, uint64_t& offset, const T* data, size_t count) {
+    const uint64_t aligned = AlignUp(offset);
+    static const char zeros[ALIGNMENT] = {};
+    out.write(zeros, static_cast<std::streamsize>(aligned - offset));
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(sizeof(T) * count));
+    offset = aligned + sizeof(T) * count;
+}
+
+// Отображение файла в память только для чтения
+std::shared_ptr<const void> MapFile(const std::string& path, size_t& size) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw SerializationError("Failed to open "s + path);
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        throw SerializationError("Not a transport catalogue file: "s + path);
+    }
+    size = static_cast<size_t>(st.st_size);
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        throw SerializationError("Failed to map "s + path);
+    }
+    return std::shared_ptr<const void>(data, [size](const void* ptr) {
+        ::munmap(const_cast<void*>(ptr), size);
+    });
+}
+
+template <typename T>
+std::span<const T> GetSection(const char* base, size_t file_size, const Section& section) {
+    if (section.offset % alignof(T) != 0 || section.offset > file_size
+        || section.count > (file_size - section.offset) / sizeof(T)) {
+        throw SerializationError("Corrupted transport catalogue file"s);
+    }
+    return {reinterpret_cast<const T*>(base + section.offset), section.count};
+}
+
+}  // namespace
+
+void SaveCatalogue(const transport::TransportCatalogue& catalogue, const std::string& path) {
+    Image image;
+    try {
+        image = catalogue.MakeImage();
+    } catch (const std::length_error&) {
+        throw SerializationError("Catalogue is too large for the binary format"s);
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.stop_index_seed = image.stop_index.seed;
+    header.bus_index_seed = image.bus_index.seed;
+    header.grid = image.grid.layout;
+
+    std::span<const char> data[SECTION_COUNT];
+    auto set_section = [&](SectionId id, auto items) {
+        header.sections[id].count = items.size();
+        data[id] = {reinterpret_cast<const char*>(items.data()), items.size_bytes()};
+    };
+    set_section(STRINGS, std::span<const char>(image.strings));
+    set_section(STOPS, image.stops);
+    set_section(BUSES, image.buses);
+    set_section(ROUTE_STOPS, image.route_stops);
+    set_section(ROAD_PREFIX, image.road_prefix);
+    set_section(DISTANCES, image.distances);
+    set_section(STOPS_BY_NAME, image.stops_by_name);
+    set_section(BUSES_BY_NAME, image.buses_by_name);
+    set_section(STOP_INDEX_PILOTS, image.stop_index.pilots);
+    set_section(STOP_INDEX_POSITIONS, image.stop_index.positions);
+    set_section(BUS_INDEX_PILOTS, image.bus_index.pilots);
+    set_section(BUS_INDEX_POSITIONS, image.bus_index.positions);
+    set_section(STOP_BUS_OFFSETS, image.stop_bus_offsets);
+    set_section(STOP_BUS_IDS, image.stop_bus_ids);
+    set_section(GRID_OFFSETS, image.grid.cell_offsets);
+    set_section(GRID_STOPS, image.grid.cell_stops);
+
+    uint64_t offset = sizeof(Header);
+    for (int id = 0; id < SECTION_COUNT; ++id) {
+        header.sections[id].offset = offset = AlignUp(offset);
+        offset += data[id].size();
+    }
+    header.file_size = offset;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw SerializationError("Failed to open "s + path + " for writing"s);
+    }
+    uint64_t written = 0;
+    WriteSection(out, written, &header, 1);
+    for (int id = 0; id < SECTION_COUNT; ++id) {
+        WriteSection(out, written, data[id].data(), data[id].size());
+    }
+    if (!out) {
+        throw SerializationError("Failed to write "s + path);
+    }
+}
+
+transport::TransportCatalogue LoadCatalogue(const std::string& path) {
+    size_t file_size = 0;
+    std::shared_ptr<const void> mapping = MapFile(path, file_size);
+    const char* base = static_cast<const char*>(mapping.get());
+
+    Header header;
+    std::memcpy(&header, base, sizeof(Header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw SerializationError("Not a transport catalogue file: "s + path);
+    }
+    if (header.version != FORMAT_VERSION) {
+        throw SerializationError("Unsupported transport catalogue format version "s
+                                 + std::to_string(header.version));
+    }
+    if (header.file_size != file_size) {
+        throw SerializationError("Truncated transport catalogue file: "s + path);
+    }
+
+    const auto section = [&](SectionId id) -> const Section& {
+        return header.sections[id];
+    };
+    Image image;
+    const auto strings = GetSection<char>(base, file_size, section(STRINGS));
+    image.strings = std::string_view(strings.data(), strings.size());
+    image.stops = GetSection<Image::StopRecord>(base, file_size, section(STOPS));
+    image.buses = GetSection<Image::BusRecord>(base, file_size, section(BUSES));
+    image.route_stops = GetSection<uint32_t>(base, file_size, section(ROUTE_STOPS));
+    image.road_prefix = GetSection<double>(base, file_size, section(ROAD_PREFIX));
+    image.distances = GetSection<Image::DistanceRecord>(base, file_size, section(DISTANCES));
+    image.stops_by_name = GetSection<uint32_t>(base, file_size, section(STOPS_BY_NAME));
+    image.buses_by_name = GetSection<uint32_t>(base, file_size, section(BUSES_BY_NAME));
+    image.stop_index = {header.stop_index_seed,
+                        GetSection<uint32_t>(base, file_size, section(STOP_INDEX_PILOTS)),
+                        GetSection<uint32_t>(base, file_size, section(STOP_INDEX_POSITIONS))};
+    image.bus_index = {header.bus_index_seed,
+                       GetSection<uint32_t>(base, file_size, section(BUS_INDEX_PILOTS)),
+                       GetSection<uint32_t>(base, file_size, section(BUS_INDEX_POSITIONS))};
+    image.stop_bus_offsets = GetSection<uint32_t>(base, file_size, section(STOP_BUS_OFFSETS));
+    image.stop_bus_ids = GetSection<uint32_t>(base, file_size, section(STOP_BUS_IDS));
+    image.grid = {header.grid,
+                  GetSection<uint32_t>(base, file_size, section(GRID_OFFSETS)),
+                  GetSection<uint32_t>(base, file_size, section(GRID_STOPS))};
+    image.storage = std::move(mapping);
+
+    try {
+        return transport::TransportCatalogue(image);
+    } catch (const std::invalid_argument&) {
+        throw SerializationError("Corrupted transport catalogue file"s);
+    }
+}
+
+}  // namespace serialization
@@ -0,0 +1,49 @@
+#pragma once
+//serialization.h
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace serialization {
+
+    struct SerializationSettings {
+        std::string file;
+    };
+
+    class SerializationError : public std::runtime_error {
+    public:
+        using runtime_error::runtime_error;
+    };
+
+    // Формат файла — образ замороженного справочника (transport::CatalogueImage);
+    // все числа в порядке байт машины, секции выровнены по 8 байт:
+    //   Header              — версия, размер файла, затравки хеш-индексов имён,
+    //                         размеры сетки остановок и таблица секций
+    //   таблица строк       — имена остановок и маршрутов подряд, без разделителей
+    //   StopRecord[]        — имя остановки как срез таблицы строк и координаты
+    //   BusRecord[]         — имя маршрута, срезы путей и нарастающих длин
+    //   uint32_t[]          — пути маршрутов в одну сторону (номера остановок)
+    //   double[]            — нарастающие дорожные длины путей
+    //   DistanceRecord[]    — дорожные расстояния по возрастанию (from, to)
+    //   uint32_t[] x 2      — номера остановок и маршрутов в порядке названий
+    //   uint32_t[] x 4      — таблицы совершенных хеш-индексов имён
+    //   uint32_t[] x 2      — номера маршрутов по остановкам
+    //   uint32_t[] x 2      — ячейки сетки остановок
+    inline constexpr char MAGIC[8] = {'T', 'C', 'A', 'T', 'B', 'I', 'N', '\0'};
+    inline constexpr uint32_t FORMAT_VERSION = 4;
+
+    // Сохраняет построенный справочник в бинарный файл.
+    // Бросает SerializationError при ошибке записи
+    void SaveCatalogue(const transport::TransportCatalogue& catalogue, const std::string& path);
+
+    // Отображает файл в память и собирает по нему замороженный справочник.
+    // Индексы, длины маршрутов, расстояния и имена справочник читает прямо
+    // со страниц файла и удерживает отображение, пока жив сам; заново
+    // создаются только объекты Stop и Bus и таблицы ключей хеш-индексов,
+    // поэтому ни Freeze, ни подбор смещений при загрузке не выполняются.
+    // Бросает SerializationError, если файл повреждён или имеет другую версию формата
+    transport::TransportCatalogue LoadCatalogue(const std::string& path);
+
+}  // namespace serialization
@@ -0,0 +1,281 @@
+#include "spatial_index.h"
+//spatial_index.cpp
+#include "transport_catalogue.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace spatial {
+namespace {
+
+// Те же константы, что и в geo::ComputeDistance
+constexpr double DEGREE = 3.1415926535 / 180.;
+constexpr double METERS_PER_DEGREE = 6371000 * DEGREE;
+constexpr double STOPS_PER_CELL = 2.0;
+// Запас на то, что на больших расстояниях дуга параллели длиннее дуги
+// большого круга, а также на погрешность вычислений
+constexpr double SAFETY = 0.999;
+
+bool Closer(const NearbyStop& lhs, const NearbyStop& rhs) {
+    if (lhs.distance != rhs.distance) {
+        return lhs.distance < rhs.distance;
+    }
+    return lhs.stop->name < rhs.stop->name;
+}
+
+size_t ToIndex(double value, size_t size) {
+    if (!(value > 0.0)) {
+        return 0;
+    }
+    return value >= static_cast<double>(size) ? size - 1 : static_cast<size_t>(value);
+}
+
+}  // namespace
+
+StopGrid::StopGrid(std::span<const transport::Stop* const> stops) {
+    if (stops.empty()) {
+        return;
+    }
+
+    double max_lat = std::numeric_limits<double>::lowest();
+    double max_lng = std::numeric_limits<double>::lowest();
+    min_lat_ = std::numeric_limits<double>::max();
+    min_lng_ = std::numeric_limits<double>::max();
+    for (const transport::Stop* stop : stops) {
+        const geo::Coordinates coordinates = geo::ToDegrees(stop->coordinates);
+        min_lat_ = std::min(min_lat_, coordinates.lat);
+        min_lng_ = std::min(min_lng_, coordinates.lng);
+        max_lat = std::max(max_lat, coordinates.lat);
+        max_lng = std::max(max_lng, coordinates.lng);
+        max_abs_lat_ = std::max(max_abs_lat_, std::abs(coordinates.lat));
+    }
+
+    // Сторона ячейки подбирается так, чтобы ячейки были квадратными в метрах
+    const double height = (max_lat - min_lat_) * METERS_PER_DEGREE;
+    const double width = (max_lng - min_lng_) * METERS_PER_DEGREE
+                         * std::cos((min_lat_ + max_lat) / 2 * DEGREE);
+    const double cell_count = std::max(1.0, stops.size() / STOPS_PER_CELL);
+    double side = std::sqrt(height * width / cell_count);
+    if (!(side > 0.0)) {
+        // Все остановки на одной линии или в одной точке
+        side = std::max(height, width) / cell_count;
+    }
+    if (side > 0.0) {
+        rows_ = static_cast<size_t>(std::clamp(std::ceil(height / side), 1.0, cell_count));
+        cols_ = static_cast<size_t>(std::clamp(std::ceil(width / side), 1.0, cell_count));
+    }
+    if (max_lat > min_lat_) {
+        lat_step_ = (max_lat - min_lat_) / rows_;
+    }
+    if (max_lng > min_lng_) {
+        lng_step_ = (max_lng - min_lng_) / cols_;
+    }
+
+    // Раскладываем номера по ячейкам подсчётом: внутри ячейки по возрастанию номера
+    std::vector<uint32_t> cells(stops.size());
+    cell_offsets_.assign(rows_ * cols_ + 1, 0);
+    for (size_t i = 0; i < stops.size(); ++i) {
+        cells[i] = static_cast<uint32_t>(CellOf(geo::ToDegrees(stops[i]->coordinates)));
+        ++cell_offsets_[cells[i] + 1];
+    }
+    for (size_t cell = 1; cell < cell_offsets_.size(); ++cell) {
+        cell_offsets_[cell] += cell_offsets_[cell - 1];
+    }
+    cell_stops_.resize(stops.size());
+    std::vector<uint32_t> next(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    for (size_t i = 0; i < stops.size(); ++i) {
+        cell_stops_[next[cells[i]]++] = stops[i]->id;
+    }
+}
+
+StopGrid::StopGrid(const Image& image, size_t stop_count)
+    : min_lat_(image.layout.min_lat)
+    , min_lng_(image.layout.min_lng)
+    , lat_step_(image.layout.lat_step)
+    , lng_step_(image.layout.lng_step)
+    , max_abs_lat_(image.layout.max_abs_lat)
+    , rows_(image.layout.rows)
+    , cols_(image.layout.cols)
+    , cell_offsets_(image.cell_offsets.begin(), image.cell_offsets.end())
+    , cell_stops_(image.cell_stops.begin(), image.cell_stops.end()) {
+    const bool valid_layout = rows_ > 0 && cols_ > 0 && lat_step_ > 0.0 && lng_step_ > 0.0
+                              && cell_offsets_.size() == rows_ * cols_ + 1;
+    if (!valid_layout || cell_offsets_.front() != 0 || cell_offsets_.back() != cell_stops_.size()
+        || !std::is_sorted(cell_offsets_.begin(), cell_offsets_.end())
+        || std::any_of(cell_stops_.begin(), cell_stops_.end(), [stop_count](uint32_t id) { return id >= stop_count; })) {
+        throw std::invalid_argument("Inconsistent stop grid image");
+    }
+}
+
+StopGrid::Image StopGrid::GetImage() const {
+    return {{min_lat_, min_lng_, lat_step_, lng_step_, max_abs_lat_,
+             static_cast<uint32_t>(rows_), static_cast<uint32_t>(cols_)},
+            cell_offsets_, cell_stops_};
+}
+
+size_t StopGrid::RowOf(double lat) const {
+    return ToIndex((lat - min_lat_) / lat_step_, rows_);
+}
+
+size_t StopGrid::ColOf(double lng) const {
+    return ToIndex((lng - min_lng_) / lng_step_, cols_);
+}
+
+size_t StopGrid::CellOf(geo::Coordinates coordinates) const {
+    return RowOf(coordinates.lat) * cols_ + ColOf(coordinates.lng);
+}
+
+std::span<const uint32_t> StopGrid::At(size_t row, size_t col) const {
+    const size_t cell = row * cols_ + col;
+    return std::span(cell_stops_).subspan(cell_offsets_[cell], cell_offsets_[cell + 1] - cell_offsets_[cell]);
+}
+
+bool StopGrid::Contains(geo::Coordinates coordinates) const {
+    return coordinates.lat >= min_lat_ && coordinates.lat <= min_lat_ + rows_ * lat_step_
+        && coordinates.lng >= min_lng_ && coordinates.lng <= min_lng_ + cols_ * lng_step_;
+}
+
+double StopGrid::RingDistance(geo::Coordinates center, size_t rings) const {
+    // Расстояние между точками не меньше R * |Δφ| и не меньше длины дуги
+    // параллели на самой удалённой от экватора из их широт
+    const double far_lat = std::min(std::max(max_abs_lat_, std::abs(center.lat)), 90.0);
+    const double lat_meters = lat_step_ * METERS_PER_DEGREE * SAFETY;
+    const double lng_meters = lng_step_ * METERS_PER_DEGREE * SAFETY * std::cos(far_lat * DEGREE);
+
+    // Если точка вне сетки, до любой остановки не ближе, чем до края сетки
+    const double row = (center.lat - min_lat_) / lat_step_;
+    const double col = (center.lng - min_lng_) / lng_step_;
+    const double outside_rows = std::max({0.0, -row, row - static_cast<double>(rows_)});
+    const double outside_cols = std::max({0.0, -col, col - static_cast<double>(cols_)});
+
+    // На малых расстояниях сфера почти плоская: катеты по широте и долготе
+    // дают нижнюю границу гипотенузы
+    const double far_by_rows = std::hypot((rings + outside_rows) * lat_meters, outside_cols * lng_meters);
+    const double far_by_cols = std::hypot(outside_rows * lat_meters, (rings + outside_cols) * lng_meters);
+    return std::min(far_by_rows, far_by_cols);
+}
+
+void StopGrid::Insert(const transport::Stop* stop, std::span<const transport::Stop* const> stops) {
+    const geo::Coordinates coordinates = geo::ToDegrees(stop->coordinates);
+    if (!Contains(coordinates)) {
+        *this = StopGrid(stops);
+        return;
+    }
+    const size_t cell = CellOf(coordinates);
+    cell_stops_.insert(cell_stops_.begin() + cell_offsets_[cell + 1], stop->id);
+    for (size_t i = cell + 1; i < cell_offsets_.size(); ++i) {
+        ++cell_offsets_[i];
+    }
+    max_abs_lat_ = std::max(max_abs_lat_, std::abs(coordinates.lat));
+}
+
+void StopGrid::Erase(uint32_t stop_id, geo::Coordinates coordinates) {
+    const size_t cell = CellOf(coordinates);
+    const auto begin = cell_stops_.begin() + cell_offsets_[cell];
+    const auto end = cell_stops_.begin() + cell_offsets_[cell + 1];
+    if (auto it = std::find(begin, end, stop_id); it != end) {
+        cell_stops_.erase(it);
+        for (size_t i = cell + 1; i < cell_offsets_.size(); ++i) {
+            --cell_offsets_[i];
+        }
+    }
+}
+
+std::vector<NearbyStop> StopGrid::FindNearest(geo::Coordinates center, size_t count,
+                                              std::span<const transport::Stop* const> stops) const {
+    std::vector<NearbyStop> result;
+    if (count == 0 || cell_stops_.empty()) {
+        return result;
+    }
+    count = std::min(count, cell_stops_.size());
+    result.reserve(count);
+
+    // result — куча с самой дальней из найденных остановок на вершине
+    auto visit = [&](size_t row, size_t col) {
+        for (uint32_t id : At(row, col)) {
+            const transport::Stop* stop = stops[id];
+            const NearbyStop candidate{stop, geo::ComputeDistance(center, geo::ToDegrees(stop->coordinates))};
+            if (result.size() < count) {
+                result.push_back(candidate);
+                std::push_heap(result.begin(), result.end(), Closer);
+            } else if (Closer(candidate, result.front())) {
+                std::pop_heap(result.begin(), result.end(), Closer);
+                result.back() = candidate;
+                std::push_heap(result.begin(), result.end(), Closer);
+            }
+        }
+    };
+
+    const size_t row = RowOf(center.lat);
+    const size_t col = ColOf(center.lng);
+    const size_t max_ring = std::max({row, rows_ - 1 - row, col, cols_ - 1 - col});
+    for (size_t ring = 0; ring <= max_ring; ++ring) {
+        // Ячейки на границе квадрата со стороной 2 * ring + 1 вокруг (row, col)
+        const size_t first_row = row >= ring ? row - ring : 0;
+        const size_t last_row = std::min(row + ring, rows_ - 1);
+        const size_t first_col = col >= ring ? col - ring : 0;
+        const size_t last_col = std::min(col + ring, cols_ - 1);
+        for (size_t r = first_row; r <= last_row; ++r) {
+            if (r + ring == row || r == row + ring) {
+                for (size_t c = first_col; c <= last_col; ++c) {
+                    visit(r, c);
+                }
+                continue;
+            }
+            if (col >= ring) {
+                visit(r, col - ring);
+            }
+            if (ring > 0 && col + ring < cols_) {
+                visit(r, col + ring);
+            }
+        }
+
+        if (result.size() == count && result.front().distance <= RingDistance(center, ring)) {
+            break;
+        }
+    }
+
+    std::sort_heap(result.begin(), result.end(), Closer);
+    return result;
+}
+
+std::vector<NearbyStop> StopGrid::FindWithin(geo::Coordinates center, double radius,
+                                             std::span<const transport::Stop* const> stops) const {
+    std::vector<NearbyStop> result;
+    if (cell_stops_.empty() || radius < 0.0) {
+        return result;
+    }
+
+    // Прямоугольник, в который заведомо попадает круг радиуса radius
+    const double lat_delta = radius / METERS_PER_DEGREE / SAFETY;
+    const double far_lat = std::min(std::abs(center.lat) + lat_delta, 90.0);
+    const double lng_scale = std::cos(far_lat * DEGREE) * SAFETY;
+    size_t first_col = 0;
+    size_t last_col = cols_ - 1;
+    if (lng_scale > 0.0) {
+        const double lng_delta = radius / METERS_PER_DEGREE / lng_scale;
+        first_col = ColOf(center.lng - lng_delta);
+        last_col = ColOf(center.lng + lng_delta);
+    }
+    const size_t first_row = RowOf(center.lat - lat_delta);
+    const size_t last_row = RowOf(center.lat + lat_delta);
+
+    for (size_t r = first_row; r <= last_row; ++r) {
+        for (size_t c = first_col; c <= last_col; ++c) {
+            for (uint32_t id : At(r, c)) {
+                const transport::Stop* stop = stops[id];
+                const double distance = geo::ComputeDistance(center, geo::ToDegrees(stop->coordinates));
+                if (distance <= radius) {
+                    result.push_back({stop, distance});
+                }
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end(), Closer);
+    return result;
+}
+
+}  // namespace spatial
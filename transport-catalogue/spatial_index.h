@@ -0,0 +1,98 @@
+#pragma once
+//spatial_index.h
+#include "geo.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace transport {
+    struct Stop;
+}
+
+namespace spatial {
+
+// Остановка и расстояние до неё в метрах
+struct NearbyStop {
+    const transport::Stop* stop;
+    double distance;
+};
+
+// Равномерная сетка над координатами остановок: ячейки примерно квадратные
+// в метрах, в среднем две остановки на ячейку. k ближайших остановок ищутся
+// обходом колец ячеек вокруг точки, пока k-я найденная не окажется ближе
+// любой остановки из ещё не обойдённых колец; поиск в радиусе просматривает
+// только ячейки, пересекающие круг. Результаты упорядочены по расстоянию,
+// при равенстве — по названию.
+// Ячейки хранят номера остановок подряд в одном массиве. Остановки по
+// номерам (stops, Stop::id — позиция в нём) передаются в поиск, и их
+// координаты читаются при поиске, поэтому перед изменением координат
+// остановку нужно убрать из сетки (Erase)
+class StopGrid {
+public:
+    // Размеры и положение сетки
+    struct Layout {
+        double min_lat = 0.0;
+        double min_lng = 0.0;
+        double lat_step = 1.0;
+        double lng_step = 1.0;
+        // Наибольшая по модулю широта среди остановок: на ней градус долготы короче всего
+        double max_abs_lat = 0.0;
+        uint32_t rows = 1;
+        uint32_t cols = 1;
+    };
+
+    // Сетка в виде плоских массивов: номера остановок ячейки i (построчно) —
+    // cell_stops с cell_offsets[i] по cell_offsets[i + 1]
+    struct Image {
+        Layout layout;
+        std::span<const uint32_t> cell_offsets;
+        std::span<const uint32_t> cell_stops;
+    };
+
+    StopGrid() = default;
+    explicit StopGrid(std::span<const transport::Stop* const> stops);
+    // Массивы образа копируются. Если они не согласованы с размерами сетки,
+    // бросается std::invalid_argument
+    StopGrid(const Image& image, size_t stop_count);
+
+    // Массивы образа ссылаются на память сетки
+    Image GetImage() const;
+
+    // Добавляет остановку, появившуюся после построения сетки. Если она
+    // лежит за пределами сетки, сетка строится заново по stops
+    void Insert(const transport::Stop* stop, std::span<const transport::Stop* const> stops);
+    // Убирает остановку, которая была добавлена с координатами coordinates
+    void Erase(uint32_t stop_id, geo::Coordinates coordinates);
+
+    std::vector<NearbyStop> FindNearest(geo::Coordinates center, size_t count,
+                                        std::span<const transport::Stop* const> stops) const;
+    std::vector<NearbyStop> FindWithin(geo::Coordinates center, double radius,
+                                       std::span<const transport::Stop* const> stops) const;
+
+private:
+    // Координаты за пределами сетки приводятся к крайним ячейкам
+    size_t RowOf(double lat) const;
+    size_t ColOf(double lng) const;
+    size_t CellOf(geo::Coordinates coordinates) const;
+    std::span<const uint32_t> At(size_t row, size_t col) const;
+    bool Contains(geo::Coordinates coordinates) const;
+    // Нижняя граница расстояния от center до остановок в ячейках, которые
+    // отстоят от ячейки center на rings + 1 и больше по строкам или столбцам
+    double RingDistance(geo::Coordinates center, size_t rings) const;
+
+    double min_lat_ = 0.0;
+    double min_lng_ = 0.0;
+    double lat_step_ = 1.0;
+    double lng_step_ = 1.0;
+    // Наибольшая по модулю широта среди остановок: на ней градус долготы короче всего
+    double max_abs_lat_ = 0.0;
+    size_t rows_ = 1;
+    size_t cols_ = 1;
+    // Начала ячеек в cell_stops_ построчно: rows_ * cols_ + 1 смещений
+    std::vector<uint32_t> cell_offsets_ = std::vector<uint32_t>(2, 0);
+    std::vector<uint32_t> cell_stops_;
+};
+
+}  // namespace spatial
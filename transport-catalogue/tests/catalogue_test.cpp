@@ -0,0 +1,149 @@
+// Проверяет контракт TransportCatalogue вокруг Freeze: списки остановок и
+// маршрутов доступны и до заморозки, а после неё справочник не меняется;
+// справочник, собранный по образу, отвечает так же, как исходный.
+// Запуск: tests/run_tests.sh
+#include "../transport_catalogue.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void Check(bool condition, const std::string& message) {
+    if (!condition) {
+        ++failures;
+        if (failures <= 20) {
+            std::cerr << "FAILED: " << message << '\n';
+        }
+    }
+}
+
+template <typename Action>
+bool Throws(Action action) {
+    try {
+        action();
+    } catch (const std::logic_error&) {
+        return true;
+    }
+    return false;
+}
+
+void CheckListsBeforeFreeze() {
+    transport::TransportCatalogue catalogue;
+    const transport::Stop* a = catalogue.AddStop("A", {55.6, 37.2});
+    const transport::Stop* b = catalogue.AddStop("B", {55.61, 37.21});
+    catalogue.AddBus("1", std::vector<std::string>{"A", "B"}, false);
+
+    Check(catalogue.GetAllStops() == std::vector<const transport::Stop*>{a, b}, "stops before Freeze");
+    Check(catalogue.GetAllBuses().size() == 1 && catalogue.GetAllBuses()[0]->name == "1", "buses before Freeze");
+
+    catalogue.Freeze();
+    Check(catalogue.GetAllStops() == std::vector<const transport::Stop*>{a, b}, "stops after Freeze");
+    Check(catalogue.GetAllBuses().size() == 1, "buses after Freeze");
+}
+
+void CheckFrozenIsReadOnly() {
+    transport::TransportCatalogue catalogue;
+    const transport::Stop* a = catalogue.AddStop("A", {55.6, 37.2});
+    catalogue.Freeze();
+    Check(Throws([&] { catalogue.AddStop("B", {55.61, 37.21}); }), "AddStop after Freeze");
+    Check(Throws([&] { catalogue.AddBus("1", std::vector<std::string>{"A"}, true); }), "AddBus after Freeze");
+    Check(Throws([&] { catalogue.SetDistance(a, a, 100); }), "SetDistance after Freeze");
+}
+
+// Сравнивает ответы двух справочников по всем остановкам и маршрутам
+void CheckSameAnswers(const transport::TransportCatalogue& lhs, const transport::TransportCatalogue& rhs,
+                      const std::string& context) {
+    Check(lhs.GetAllStops().size() == rhs.GetAllStops().size(), context + ": stop count");
+    for (const transport::Stop* stop : lhs.GetAllStops()) {
+        const transport::Stop* other = rhs.FindStop(stop->name);
+        Check(other && other->id == stop->id && other->coordinates == stop->coordinates,
+              context + ": stop " + std::string(stop->name));
+        std::vector<std::string_view> lhs_buses;
+        std::vector<std::string_view> rhs_buses;
+        for (const transport::Bus* bus : lhs.GetBusesForStop(stop->name)) {
+            lhs_buses.push_back(bus->name);
+        }
+        for (const transport::Bus* bus : rhs.GetBusesForStop(stop->name)) {
+            rhs_buses.push_back(bus->name);
+        }
+        Check(lhs_buses == rhs_buses, context + ": buses for stop " + std::string(stop->name));
+        for (const transport::Stop* to : lhs.GetAllStops()) {
+            Check(lhs.GetDistance(stop, to) == rhs.GetDistance(other, rhs.FindStop(to->name)),
+                  context + ": distance " + std::string(stop->name) + " - " + std::string(to->name));
+        }
+    }
+    Check(lhs.GetAllBuses().size() == rhs.GetAllBuses().size(), context + ": bus count");
+    for (const transport::Bus* bus : lhs.GetAllBuses()) {
+        const transport::BusInfo lhs_info = lhs.GetBusInfo(bus->name);
+        const transport::BusInfo rhs_info = rhs.GetBusInfo(bus->name);
+        Check(rhs_info.exists && lhs_info.total_stops == rhs_info.total_stops
+                  && lhs_info.unique_stops == rhs_info.unique_stops && lhs_info.route_length == rhs_info.route_length
+                  && lhs_info.curvature == rhs_info.curvature,
+              context + ": bus " + std::string(bus->name));
+    }
+    Check(lhs.SearchStops("", 100).size() == rhs.SearchStops("", 100).size(), context + ": stops by name");
+    const auto lhs_nearest = lhs.FindNearestStops({55.6, 37.2}, 3);
+    const auto rhs_nearest = rhs.FindNearestStops({55.6, 37.2}, 3);
+    Check(lhs_nearest.size() == rhs_nearest.size()
+              && std::equal(lhs_nearest.begin(), lhs_nearest.end(), rhs_nearest.begin(),
+                            [](const auto& lhs, const auto& rhs) { return lhs.stop->name == rhs.stop->name; }),
+          context + ": nearest stops");
+}
+
+void CheckImageRoundTrip() {
+    transport::TransportCatalogue catalogue;
+    const transport::Stop* a = catalogue.AddStop("A", {55.6, 37.2});
+    const transport::Stop* b = catalogue.AddStop("B", {55.61, 37.21});
+    const transport::Stop* c = catalogue.AddStop("C", {55.62, 37.19});
+    catalogue.SetDistance(a, b, 1500);
+    catalogue.SetDistance(c, b, 900);
+    catalogue.AddBus("1", std::vector<std::string>{"A", "B", "C"}, false);
+    catalogue.AddBus("2", std::vector<std::string>{"C", "A", "B", "C"}, true);
+    catalogue.AddBus("3", std::vector<std::string>{"B", "C", "X"}, false);
+    catalogue.Freeze();
+    CheckSameAnswers(catalogue, transport::TransportCatalogue(catalogue.MakeImage()), "frozen");
+
+    transport::CatalogueUpdate update;
+    update.stops.push_back({"D", {55.63, 37.22}, {{"A", 700}}});
+    update.stops.push_back({"B", {55.605, 37.215}, {{"C", 1100}}});
+    update.buses.push_back({"1", {"A", "D", "B"}, false});
+    update.buses.push_back({"4", {"D", "C"}, false});
+    transport::CatalogueDelta delta;
+    catalogue = catalogue.WithUpdate(update, delta);
+    CheckSameAnswers(catalogue, transport::TransportCatalogue(catalogue.MakeImage()), "updated");
+
+    // Номер остановки за пределами массива
+    transport::CatalogueImage image = catalogue.MakeImage();
+    std::vector<uint32_t> route_stops(image.route_stops.begin(), image.route_stops.end());
+    route_stops.front() = 1000;
+    image.route_stops = route_stops;
+    bool rejected = false;
+    try {
+        transport::TransportCatalogue broken(image);
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    Check(rejected, "inconsistent image rejected with invalid_argument");
+}
+
+}  // namespace
+
+int main() {
+    CheckListsBeforeFreeze();
+    CheckFrozenIsReadOnly();
+    CheckImageRoundTrip();
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "catalogue_test: OK\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+// Проверяет transport::VersionedCatalogue: читатели, работающие во время
+// обновлений, видят каждую версию целиком и не видят версий старее уже
+// виденной; одновременные писатели не теряют изменений; старая версия
+// отвечает по-старому, пока закреплена, и освобождается, когда отпущена.
+// Запуск: tests/run_tests.sh
+#include "../catalogue_version.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<int> failures = 0;
+
+void Check(bool condition, const std::string& message) {
+    if (!condition) {
+        if (++failures <= 20) {
+            std::cerr << "FAILED: " << message << '\n';
+        }
+    }
+}
+
+bool Near(double lhs, double rhs) {
+    return std::abs(lhs - rhs) <= 1e-9 * std::max(1.0, std::abs(rhs));
+}
+
+const transport_router::RoutingSettings SETTINGS{6, 40.0};
+const size_t STOP_COUNT = 20;
+
+std::string StopName(size_t i) {
+    return "Stop " + std::to_string(i);
+}
+
+// Кольцевой маршрут по всем остановкам; расстояние между соседними — 1000 м
+transport::TransportCatalogue MakeCatalogue() {
+    transport::TransportCatalogue catalogue;
+    std::vector<const transport::Stop*> stops;
+    std::vector<std::string> route;
+    for (size_t i = 0; i < STOP_COUNT; ++i) {
+        stops.push_back(catalogue.AddStop(StopName(i), {55.6 + 0.001 * i, 37.6}));
+        route.push_back(StopName(i));
+    }
+    route.push_back(StopName(0));
+    for (size_t i = 0; i < STOP_COUNT; ++i) {
+        catalogue.SetDistance(stops[i], stops[(i + 1) % STOP_COUNT], 1000);
+    }
+    catalogue.AddBus("Ring", route, true);
+    catalogue.Freeze();
+    return catalogue;
+}
+
+// Новое расстояние от первой остановки до второй
+transport::CatalogueUpdate MakeDistanceUpdate(int distance) {
+    transport::CatalogueUpdate update;
+    update.stops.push_back({StopName(0), {55.6, 37.6}, {{StopName(1), distance}}});
+    return update;
+}
+
+double RouteTime(const transport::CatalogueVersion& version, size_t from, size_t to) {
+    const auto route = version.Router().GetOptimalRoute(version.Catalogue().FindStop(StopName(from)),
+                                                        version.Catalogue().FindStop(StopName(to)));
+    return route ? route->total_time : -1.0;
+}
+
+// Маршрутизатор версии построен по её же справочнику: время поездки от
+// первой остановки до второй сходится с расстоянием в справочнике
+void CheckConsistent(const transport::CatalogueVersion& version, const std::string& context) {
+    const transport::TransportCatalogue& catalogue = version.Catalogue();
+    const int distance = catalogue.GetDistance(catalogue.FindStop(StopName(0)), catalogue.FindStop(StopName(1)));
+    const double expected = SETTINGS.bus_wait_time + distance / (SETTINGS.bus_velocity * 1000.0 / 60.0);
+    Check(Near(RouteTime(version, 0, 1), expected), context + ": router matches catalogue");
+}
+
+void CheckConcurrentReaders() {
+    transport::VersionedCatalogue versions(MakeCatalogue(), SETTINGS);
+    const int update_count = 200;
+    std::atomic<bool> done = false;
+    std::atomic<int> started = 0;
+    std::atomic<int> overlapped = 0;
+
+    std::vector<std::thread> readers;
+    for (int reader = 0; reader < 4; ++reader) {
+        readers.emplace_back([&, reader] {
+            uint64_t last = 0;
+            ++started;
+            while (!done.load()) {
+                const transport::CatalogueVersionPtr version = versions.Pin();
+                // Версия, опубликованная одним из писателей
+                if (version->Number() > 0) {
+                    ++overlapped;
+                }
+                Check(version->Number() >= last, "reader " + std::to_string(reader) + ": versions go forward");
+                last = version->Number();
+                CheckConsistent(*version, "reader " + std::to_string(reader));
+            }
+        });
+    }
+
+    while (started.load() < static_cast<int>(readers.size())) {
+        std::this_thread::yield();
+    }
+    std::vector<std::thread> writers;
+    for (int writer = 0; writer < 2; ++writer) {
+        writers.emplace_back([&, writer] {
+            for (int i = 0; i < update_count / 2; ++i) {
+                versions.Update(MakeDistanceUpdate(500 + 10 * i + writer));
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    // Каждое обновление дало свою версию
+    Check(overlapped.load() > 0, "readers ran during updates");
+    const transport::CatalogueVersionPtr last = versions.Pin();
+    Check(last->Number() == static_cast<uint64_t>(update_count), "no update lost");
+    CheckConsistent(*last, "last version");
+
+    // Маршрутизатор последней версии отвечает как построенный заново
+    const transport_router::TransportRouter rebuilt(last->Catalogue(), SETTINGS);
+    for (size_t from = 0; from < STOP_COUNT; ++from) {
+        for (size_t to = 0; to < STOP_COUNT; ++to) {
+            const auto rhs = rebuilt.GetOptimalRoute(last->Catalogue().FindStop(StopName(from)),
+                                                     last->Catalogue().FindStop(StopName(to)));
+            Check(rhs && Near(RouteTime(*last, from, to), rhs->total_time),
+                  "last version: route " + StopName(from) + " -> " + StopName(to));
+        }
+    }
+}
+
+void CheckPinnedVersion() {
+    transport::VersionedCatalogue versions(MakeCatalogue(), SETTINGS);
+    transport::CatalogueVersionPtr pinned = versions.Pin();
+    const double before = RouteTime(*pinned, 0, 1);
+    const double before_back = RouteTime(*pinned, 1, 0);
+
+    const auto result = versions.Update(MakeDistanceUpdate(3000));
+    Check(result.version == versions.Pin(), "update publishes its version");
+    Check(result.delta.changed_buses.size() == 1, "update delta");
+    Check(RouteTime(*versions.Pin(), 0, 1) > before, "new version sees the update");
+
+    // Закреплённая версия отвечает так же, как до обновления
+    Check(RouteTime(*pinned, 0, 1) == before && RouteTime(*pinned, 1, 0) == before_back,
+          "pinned version keeps its answers");
+    CheckConsistent(*pinned, "pinned version");
+
+    const std::weak_ptr<const transport::CatalogueVersion> released = pinned;
+    pinned.reset();
+    Check(released.expired(), "released version is freed");
+    CheckConsistent(*versions.Pin(), "version after release");
+
+    // Отрицательное время поездки маршрутизатор отвергает, и версия с ним
+    // не публикуется
+    transport::CatalogueUpdate broken;
+    broken.stops.push_back({StopName(0), {55.6, 37.6}, {{StopName(1), -1000}}});
+    const transport::CatalogueVersionPtr current = versions.Pin();
+    bool thrown = false;
+    try {
+        versions.Update(broken);
+    } catch (const std::domain_error&) {
+        thrown = true;
+    }
+    Check(thrown && versions.Pin() == current, "failed update leaves current version");
+}
+
+}  // namespace
+
+int main() {
+    CheckConcurrentReaders();
+    CheckPinnedVersion();
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "catalogue_version_test: OK\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+// Проверяет хранение координат в миллионных долях градуса
+// (geo::MicroCoordinates, сборка с -DTRANSPORT_MICRO_COORDINATES):
+// координаты с шестью знаками после запятой переживают перевод туда и
+// обратно без потерь, и расстояния совпадают с посчитанными по double.
+// Запуск: tests/run_tests.sh
+#include "../geo.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void Check(bool condition, const std::string& message) {
+    if (!condition) {
+        ++failures;
+        if (failures <= 20) {
+            std::cerr << "FAILED: " << message << '\n';
+        }
+    }
+}
+
+// Так же, как значение попадает в программу из JSON: через десятичную запись
+double ParseDecimal(double value, int digits) {
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.*f", digits, value);
+    return std::strtod(text, nullptr);
+}
+
+std::string ToString(geo::Coordinates coordinates) {
+    char text[64];
+    std::snprintf(text, sizeof(text), "(%.17g, %.17g)", coordinates.lat, coordinates.lng);
+    return text;
+}
+
+void CheckSixDigitRoundTrip(std::mt19937& random) {
+    std::uniform_real_distribution<double> lat(-90.0, 90.0);
+    std::uniform_real_distribution<double> lng(-180.0, 180.0);
+    for (int i = 0; i < 100'000; ++i) {
+        const geo::Coordinates from{ParseDecimal(lat(random), 6), ParseDecimal(lng(random), 6)};
+        const geo::Coordinates to{ParseDecimal(lat(random), 6), ParseDecimal(lng(random), 6)};
+        const geo::MicroCoordinates micro_from(from);
+        const geo::MicroCoordinates micro_to(to);
+
+        Check(geo::ToDegrees(micro_from) == from, "round trip of " + ToString(from));
+        Check(geo::ComputeDistance(micro_from, micro_to) == geo::ComputeDistance(from, to),
+              "distance " + ToString(from) + " - " + ToString(to));
+    }
+}
+
+// Более точные координаты округляются до ближайшей миллионной доли градуса:
+// на широте Москвы это не больше 6 сантиметров по каждой оси
+void CheckRounding(std::mt19937& random) {
+    std::uniform_real_distribution<double> lat(55.0, 56.0);
+    std::uniform_real_distribution<double> lng(37.0, 38.0);
+    for (int i = 0; i < 100'000; ++i) {
+        const geo::Coordinates from{lat(random), lng(random)};
+        const geo::Coordinates to{lat(random), lng(random)};
+        const geo::Coordinates rounded = geo::ToDegrees(geo::MicroCoordinates(from));
+
+        Check(std::abs(rounded.lat - from.lat) <= 0.5e-6 + 1e-12 && std::abs(rounded.lng - from.lng) <= 0.5e-6 + 1e-12,
+              "rounding of " + ToString(from));
+        const double error = std::abs(geo::ComputeDistance(geo::MicroCoordinates(from), geo::MicroCoordinates(to))
+                                      - geo::ComputeDistance(from, to));
+        Check(error < 0.2, "distance error " + std::to_string(error) + " m for " + ToString(from));
+    }
+}
+
+void CheckEqualPoints() {
+    const geo::Coordinates point{55.611087, 37.20829};
+    Check(geo::ComputeDistance(geo::MicroCoordinates(point), geo::MicroCoordinates(point)) == 0.0,
+          "distance between equal points");
+    Check(geo::MicroCoordinates(point) == geo::MicroCoordinates(geo::Coordinates{55.6110871, 37.2082899}),
+          "points within half a micro-degree are equal");
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 random(39);
+    CheckSixDigitRoundTrip(random);
+    CheckRounding(random);
+    CheckEqualPoints();
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "geo_test: OK\n";
+    return EXIT_SUCCESS;
+}
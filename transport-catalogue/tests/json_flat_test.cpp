@@ -0,0 +1,104 @@
+// Проверяет json::FlatDocument: плоское дерево содержит то же, что дерево
+// json::Node из того же текста; поиск по ключу работает и в маленьких, и в
+// больших словарях; FlatBuilder собирает значения по очереди в одну арену
+// и после ошибки разбора продолжает со следующего.
+// Запуск: tests/run_tests.sh
+#include "../json.h"
+#include "../json_flat.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void Check(bool condition, const std::string& message) {
+    if (!condition) {
+        ++failures;
+        if (failures <= 20) {
+            std::cerr << "FAILED: " << message << '\n';
+        }
+    }
+}
+
+void CheckSameAsTree() {
+    for (const char* path : {"data/example.json", "data/network.json"}) {
+        std::ifstream input(path, std::ios::binary);
+        const std::string text = json::ReadAll(input);
+        Check(!text.empty(), std::string(path) + ": read");
+        Check(json::LoadFlat(text).GetRoot().ToNode() == json::Load(text).GetRoot(), std::string(path) + ": same tree");
+    }
+}
+
+void CheckFind() {
+    // Больше восьми ключей — поиск двоичный
+    std::string text = "{";
+    for (int i = 0; i < 20; ++i) {
+        text += (i > 0 ? ", \"key " : "\"key ") + std::to_string(i) + "\": " + std::to_string(i);
+    }
+    text += ", \"small\": {\"b\": 1, \"a\": \"x\"}}";
+    const json::FlatDocument doc = json::LoadFlat(text);
+    for (int i = 0; i < 20; ++i) {
+        const json::FlatNode* value = doc.GetRoot().Find("key " + std::to_string(i));
+        Check(value && value->AsInt() == i, "find key " + std::to_string(i));
+    }
+    Check(!doc.GetRoot().Find("key 20"), "missing key");
+    const json::FlatNode* small = doc.GetRoot().Find("small");
+    Check(small && small->Find("a")->AsString() == "x" && !small->Find("c"), "small dict");
+    Check(small && small->AsDict().front().key == "a", "keys sorted");
+
+    bool rejected = false;
+    try {
+        json::LoadFlat(R"({"a": 1, "b": 2, "a": 3})");
+    } catch (const json::ParsingError&) {
+        rejected = true;
+    }
+    Check(rejected, "duplicate key rejected");
+}
+
+void CheckSequentialValues() {
+    const std::vector<std::string_view> texts = {
+        R"({"type": "Stop", "name": "A", "road_distances": {"B": 100}})",
+        R"({"type": "Stop", "name": )",
+        R"({"type": "Bus", "name": "1", "stops": ["A", "B"]})",
+    };
+    json::FlatBuilder builder;
+    std::vector<json::FlatNode> roots;
+    for (std::string_view text : texts) {
+        try {
+            json::Parse(text, builder);
+            roots.push_back(builder.ExtractRoot());
+        } catch (const json::ParsingError&) {
+            builder.Reset();
+        }
+    }
+    const json::FlatDocument arena = builder.Extract();
+    Check(roots.size() == 2, "broken value skipped");
+    if (roots.size() == 2) {
+        Check(roots[0].Find("road_distances")->Find("B")->AsInt() == 100, "first value");
+        Check(roots[1].Find("stops")->AsArray().size() == 2 && roots[1].Find("name")->AsString() == "1",
+              "value after error");
+        // Ключ "type" повторяется и хранится один раз
+        Check(roots[0].AsDict().back().key.data() == roots[1].AsDict().back().key.data(), "repeated key interned");
+    }
+}
+
+}  // namespace
+
+int main() {
+    CheckSameAsTree();
+    CheckFind();
+    CheckSequentialValues();
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "json_flat_test: OK\n";
+    return EXIT_SUCCESS;
+}
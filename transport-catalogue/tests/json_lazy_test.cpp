@@ -0,0 +1,91 @@
+// Проверяет json::LazyNode и отложенные разделы DocumentReader: массив
+// разбирается при первом AsArray и только на один уровень, поддерево
+// совпадает с деревом json::Node из того же текста, а раздел, отложенный
+// при чтении документа, не попадает в документ и читается потом.
+// Запуск: tests/run_tests.sh
+#include "../json_lazy.h"
+#include "../json_reader.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void Check(bool condition, const std::string& message) {
+    if (!condition) {
+        ++failures;
+        if (failures <= 20) {
+            std::cerr << "FAILED: " << message << '\n';
+        }
+    }
+}
+
+void CheckMaterialization() {
+    const std::string text = R"([{"id": 1, "type": "Bus", "name": "14"}, [1, 2.5, "x"], 7, null])";
+    const json::LazyDocument doc = json::LoadLazy(text);
+    const json::LazyNode& root = doc.GetRoot();
+    Check(root.IsArray() && !root.IsMaterialized(), "root is not parsed before AsArray");
+
+    const json::LazyArray& items = root.AsArray();
+    Check(root.IsMaterialized() && items.size() == 4, "AsArray parses one level");
+    Check(items[0].IsDict() && !items[0].IsMaterialized(), "nested dict stays unparsed");
+    Check(items[2].AsInt() == 7 && items[3].IsNull(), "scalars are parsed");
+    Check(items[0].AsDict().at("name").AsString() == "14", "nested dict on demand");
+    Check(items[1].ToNode() == json::Load(R"([1, 2.5, "x"])").GetRoot(), "ToNode of unparsed array");
+    Check(root.ToNode() == json::Load(text).GetRoot(), "ToNode of the whole document");
+
+    // Ошибка внутри массива обнаруживается только при его разборе
+    const json::LazyDocument broken = json::LoadLazy(R"({"a": [1, 2,, 3], "b": 4})");
+    Check(broken.GetRoot().AsDict().at("b").AsInt() == 4, "sibling of a broken array");
+    bool rejected = false;
+    try {
+        broken.GetRoot().AsDict().at("a").AsArray();
+    } catch (const json::ParsingError&) {
+        rejected = true;
+    }
+    Check(rejected, "broken array rejected on AsArray");
+}
+
+void CheckDeferredSection() {
+    const std::string text = R"({"routing_settings": {"bus_wait_time": 6, "bus_velocity": 40},
+                                 "stat_requests": [{"id": 1, "type": "Stop", "name": "A"}],
+                                 "base_requests": []})";
+    input::DocumentReader reader;
+    reader.DeferSection("stat_requests");
+    json::Parse(text, reader);
+    const json::Document doc = reader.ExtractDocument();
+    const json::LazyDocument stat_requests = reader.ExtractDeferredSection("stat_requests");
+    Check(doc.GetRoot().AsDict().count("stat_requests") == 0, "deferred section is not in the document");
+    Check(doc.GetRoot().AsDict().count("routing_settings") == 1, "other sections are in the document");
+    Check(stat_requests.GetRoot().IsArray() && stat_requests.GetRoot().AsArray().size() == 1
+              && stat_requests.GetRoot().AsArray()[0].AsDict().at("name").AsString() == "A",
+          "deferred section is read later");
+    Check(reader.ExtractDeferredSection("render_settings").GetRoot().IsNull(), "missing section is null");
+
+    input::DocumentReader duplicate;
+    duplicate.DeferSection("stat_requests");
+    bool rejected = false;
+    try {
+        json::Parse(R"({"stat_requests": [], "stat_requests": []})", duplicate);
+    } catch (const json::ParsingError&) {
+        rejected = true;
+    }
+    Check(rejected, "duplicate deferred section rejected");
+}
+
+}  // namespace
+
+int main() {
+    CheckMaterialization();
+    CheckDeferredSection();
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "json_lazy_test: OK\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+// Проверяет perfect_hash::StringIndex: каждый ключ находится на своей
+// позиции, отсутствующие не находятся, а повторяющиеся ключи отвергаются
+// сразу, без перебора смещений.
+// Запуск: tests/run_tests.sh
+#include "../perfect_hash.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void Check(bool condition, const std::string& message) {
+    if (!condition) {
+        ++failures;
+        if (failures <= 20) {
+            std::cerr << "FAILED: " << message << '\n';
+        }
+    }
+}
+
+std::vector<std::string> MakeNames(size_t count, std::string_view prefix) {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; ++i) {
+        names.push_back(std::string(prefix) + std::to_string(i));
+    }
+    return names;
+}
+
+void CheckLookups() {
+    const std::vector<std::string> names = MakeNames(50'000, "Остановка ");
+    const std::vector<std::string_view> keys(names.begin(), names.end());
+    const perfect_hash::StringIndex index(keys);
+
+    Check(index.Size() == keys.size(), "index size");
+    for (size_t i = 0; i < keys.size(); ++i) {
+        Check(index.Find(keys[i]) == i, "position of " + names[i]);
+    }
+    for (const std::string& missing : MakeNames(1'000, "Нет ")) {
+        Check(index.Find(missing) == perfect_hash::StringIndex::npos, "missing " + missing);
+    }
+    Check(perfect_hash::StringIndex().Find("") == perfect_hash::StringIndex::npos, "empty index");
+}
+
+void CheckDuplicates() {
+    std::vector<std::string> names = MakeNames(50'000, "Маршрут ");
+    names.push_back(names[12'345]);
+    const std::vector<std::string_view> keys(names.begin(), names.end());
+
+    const auto start = std::chrono::steady_clock::now();
+    bool rejected = false;
+    try {
+        perfect_hash::StringIndex index(keys);
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    Check(rejected, "duplicate key rejected with invalid_argument");
+    // Перебор смещений занял бы минуты
+    Check(elapsed < std::chrono::seconds(1), "duplicate key rejected without searching pilots");
+}
+
+}  // namespace
+
+int main() {
+    CheckLookups();
+    CheckDuplicates();
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "perfect_hash_test: OK\n";
+    return EXIT_SUCCESS;
+}
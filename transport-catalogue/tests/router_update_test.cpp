@@ -0,0 +1,263 @@
+// Проверяет, что TransportCatalogue::WithUpdate вместе с
+// TransportRouter::Update дают те же ответы, что справочник и
+// маршрутизатор, построенные заново по тем же данным, а прежняя версия
+// справочника при этом не меняется.
+// Запуск: tests/run_tests.sh
+#include "../transport_catalogue.h"
+#include "../transport_router.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void Check(bool condition, const std::string& message) {
+    if (!condition) {
+        ++failures;
+        if (failures <= 20) {
+            std::cerr << "FAILED: " << message << '\n';
+        }
+    }
+}
+
+bool Near(double lhs, double rhs) {
+    return std::abs(lhs - rhs) <= 1e-9 * std::max(1.0, std::abs(rhs));
+}
+
+const transport_router::RoutingSettings SETTINGS{6, 40.0};
+
+// Данные сети, по которым строится справочник с нуля
+struct Network {
+    std::map<std::string, geo::Coordinates> stops;
+    std::map<std::pair<std::string, std::string>, int> distances;
+    std::map<std::string, std::pair<std::vector<std::string>, bool>> buses;
+};
+
+transport::TransportCatalogue Build(const Network& network) {
+    transport::TransportCatalogue catalogue;
+    for (const auto& [name, coordinates] : network.stops) {
+        catalogue.AddStop(name, coordinates);
+    }
+    for (const auto& [stops, distance] : network.distances) {
+        catalogue.SetDistance(catalogue.FindStop(stops.first), catalogue.FindStop(stops.second), distance);
+    }
+    for (const auto& [name, bus] : network.buses) {
+        catalogue.AddBus(name, bus.first, bus.second);
+    }
+    catalogue.Freeze();
+    return catalogue;
+}
+
+// То же, что делает WithUpdate: сначала все остановки, затем расстояния,
+// затем маршруты
+void Apply(Network& network, const transport::CatalogueUpdate& update) {
+    for (const auto& stop : update.stops) {
+        network.stops[stop.name] = stop.coordinates;
+    }
+    for (const auto& stop : update.stops) {
+        for (const auto& [to, distance] : stop.road_distances) {
+            network.distances[{stop.name, to}] = distance;
+        }
+    }
+    for (const auto& bus : update.buses) {
+        network.buses[bus.name] = {bus.stops, bus.is_roundtrip};
+    }
+}
+
+class Generator {
+public:
+    explicit Generator(unsigned seed) : random_(seed) {
+    }
+
+    size_t Index(size_t size) {
+        return std::uniform_int_distribution<size_t>(0, size - 1)(random_);
+    }
+
+    bool Chance(double probability) {
+        return std::bernoulli_distribution(probability)(random_);
+    }
+
+    geo::Coordinates Coordinates() {
+        std::uniform_real_distribution<double> offset(0.0, 0.1);
+        return {55.5 + offset(random_), 37.5 + offset(random_)};
+    }
+
+    int Distance() {
+        return std::uniform_int_distribution<int>(200, 5000)(random_);
+    }
+
+    // Маршрут по случайным остановкам; у кольцевого последняя совпадает с первой
+    std::vector<std::string> Route(const std::vector<std::string>& names, bool is_roundtrip) {
+        std::vector<std::string> stops;
+        const size_t count = 2 + Index(6);
+        for (size_t i = 0; i < count; ++i) {
+            stops.push_back(names[Index(names.size())]);
+        }
+        if (is_roundtrip) {
+            stops.push_back(stops.front());
+        }
+        return stops;
+    }
+
+private:
+    std::mt19937 random_;
+};
+
+std::vector<std::string> StopNames(const Network& network) {
+    std::vector<std::string> names;
+    for (const auto& [name, coordinates] : network.stops) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+Network MakeNetwork(Generator& generator, size_t stop_count, size_t bus_count) {
+    Network network;
+    for (size_t i = 0; i < stop_count; ++i) {
+        network.stops["Stop " + std::to_string(i)] = generator.Coordinates();
+    }
+    const std::vector<std::string> names = StopNames(network);
+    for (size_t i = 0; i < bus_count; ++i) {
+        const bool is_roundtrip = generator.Chance(0.5);
+        network.buses["Bus " + std::to_string(i)] = {generator.Route(names, is_roundtrip), is_roundtrip};
+    }
+    // Расстояния задаются для большинства соседних остановок маршрутов,
+    // а для некоторых — только в обратную сторону
+    for (const auto& [name, bus] : network.buses) {
+        for (size_t i = 0; i + 1 < bus.first.size(); ++i) {
+            if (generator.Chance(0.9)) {
+                network.distances[{bus.first[i], bus.first[i + 1]}] = generator.Distance();
+            }
+        }
+    }
+    return network;
+}
+
+// Изменения одного раунда: change_count переносов, новых расстояний и изменённых маршрутов
+transport::CatalogueUpdate MakeUpdate(Generator& generator, const Network& network, size_t change_count, int round) {
+    transport::CatalogueUpdate update;
+    std::vector<std::string> names = StopNames(network);
+    std::vector<std::string> new_names;
+    for (size_t i = 0; i < change_count; ++i) {
+        const std::string name = "New stop " + std::to_string(round) + "-" + std::to_string(i);
+        update.stops.push_back({name, generator.Coordinates(), {{names[generator.Index(names.size())], generator.Distance()}}});
+        new_names.push_back(name);
+    }
+    for (size_t i = 0; i < change_count; ++i) {
+        const std::string& name = names[generator.Index(names.size())];
+        const bool moved = generator.Chance(0.5);
+        transport::StopUpdate stop{name, moved ? generator.Coordinates() : network.stops.at(name), {}};
+        if (!moved || generator.Chance(0.5)) {
+            stop.road_distances.emplace_back(names[generator.Index(names.size())], generator.Distance());
+        }
+        update.stops.push_back(std::move(stop));
+    }
+
+    names.insert(names.end(), new_names.begin(), new_names.end());
+    std::vector<std::string> bus_names;
+    for (const auto& [name, bus] : network.buses) {
+        bus_names.push_back(name);
+    }
+    for (size_t i = 0; i < change_count; ++i) {
+        const bool is_roundtrip = generator.Chance(0.5);
+        const std::string name = generator.Chance(0.7) ? bus_names[generator.Index(bus_names.size())]
+                                                       : "New bus " + std::to_string(round) + "-" + std::to_string(i);
+        std::vector<std::string> stops = generator.Route(names, is_roundtrip);
+        // Изредка маршрут ссылается на неописанную остановку, в том числе конечную
+        if (generator.Chance(0.2)) {
+            stops.insert(stops.begin() + generator.Index(stops.size() + 1), "Undefined stop");
+        }
+        update.buses.push_back({name, std::move(stops), is_roundtrip});
+    }
+    return update;
+}
+
+void Compare(const Network& network,
+             const transport::TransportCatalogue& updated, const transport_router::TransportRouter& updated_router,
+             const transport::TransportCatalogue& rebuilt, const transport_router::TransportRouter& rebuilt_router,
+             const std::string& context) {
+    for (const auto& [name, bus] : network.buses) {
+        const transport::BusInfo lhs = updated.GetBusInfo(name);
+        const transport::BusInfo rhs = rebuilt.GetBusInfo(name);
+        Check(lhs.exists && rhs.exists && lhs.total_stops == rhs.total_stops && lhs.unique_stops == rhs.unique_stops
+                  && lhs.route_length == rhs.route_length && Near(lhs.curvature, rhs.curvature),
+              context + ": bus info of " + name);
+    }
+
+    const std::vector<std::string> names = StopNames(network);
+    for (const std::string& from : names) {
+        const std::vector<const transport::Bus*> lhs_buses = updated.GetBusesForStop(from);
+        const std::vector<const transport::Bus*> rhs_buses = rebuilt.GetBusesForStop(from);
+        Check(std::equal(lhs_buses.begin(), lhs_buses.end(), rhs_buses.begin(), rhs_buses.end(),
+                         [](const transport::Bus* lhs, const transport::Bus* rhs) { return lhs->name == rhs->name; }),
+              context + ": buses for stop " + from);
+
+        for (const std::string& to : names) {
+            const auto lhs = updated_router.GetOptimalRoute(updated.FindStop(from), updated.FindStop(to));
+            const auto rhs = rebuilt_router.GetOptimalRoute(rebuilt.FindStop(from), rebuilt.FindStop(to));
+            Check(lhs.has_value() == rhs.has_value() && (!lhs || Near(lhs->total_time, rhs->total_time)),
+                  context + ": route " + from + " -> " + to);
+        }
+    }
+}
+
+// Раунды с одним изменением пересчитывают отдельные строки таблицы
+// маршрутов, с большим числом изменений — всю таблицу
+void RunScenario(unsigned seed, size_t stop_count, size_t bus_count, const std::vector<size_t>& rounds) {
+    Generator generator(seed);
+    Network network = MakeNetwork(generator, stop_count, bus_count);
+    transport::TransportCatalogue catalogue = Build(network);
+    transport_router::TransportRouter router(catalogue, SETTINGS);
+
+    for (size_t round = 0; round < rounds.size(); ++round) {
+        const transport::CatalogueUpdate update = MakeUpdate(generator, network, rounds[round], static_cast<int>(round));
+        const Network previous = network;
+        Apply(network, update);
+        transport::CatalogueDelta delta;
+        transport::TransportCatalogue next = catalogue.WithUpdate(update, delta);
+        // Прежняя версия отвечает так же, как до изменений
+        const transport::TransportCatalogue previous_rebuilt = Build(previous);
+        for (const auto& [name, bus] : previous.buses) {
+            const transport::BusInfo lhs = catalogue.GetBusInfo(name);
+            const transport::BusInfo rhs = previous_rebuilt.GetBusInfo(name);
+            Check(lhs.route_length == rhs.route_length && Near(lhs.curvature, rhs.curvature),
+                  "seed " + std::to_string(seed) + ", round " + std::to_string(round) + ": previous version of " + name);
+        }
+        for (const auto& [name, coordinates] : previous.stops) {
+            Check(catalogue.FindStop(name)->coordinates == transport::StopCoordinates(coordinates),
+                  "seed " + std::to_string(seed) + ", round " + std::to_string(round) + ": previous version of " + name);
+        }
+        catalogue = std::move(next);
+        router.Update(catalogue, delta);
+
+        const transport::TransportCatalogue rebuilt = Build(network);
+        const transport_router::TransportRouter rebuilt_router(rebuilt, SETTINGS);
+        Compare(network, catalogue, router, rebuilt, rebuilt_router,
+                "seed " + std::to_string(seed) + ", round " + std::to_string(round));
+    }
+}
+
+}  // namespace
+
+int main() {
+    RunScenario(1, 40, 10, {1, 1, 1, 2, 1});
+    RunScenario(2, 80, 25, {1, 3, 10, 1, 30, 1});
+    RunScenario(3, 120, 40, {2, 1, 1, 1, 1, 1, 1, 1});
+    // Много раундов подряд: граф маршрутизатора успевает уплотниться
+    RunScenario(4, 30, 8, std::vector<size_t>(25, 2));
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "router_update_test: OK\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,36 @@
+#!/bin/bash
+# Собирает и запускает проверки из этого каталога. Каждая проверка
+# компонуется со всеми исходниками программы, кроме main.cpp. Затем
+# программа собирается с обоими способами хранения координат, и её ответы
+# на документы из data/ должны совпасть байт в байт, а если рядом с
+# документом лежит <имя>.expected, то и с ним
+set -e
+cd "$(dirname "$0")"
+OUT=${BUILD_DIR:-/tmp/transport_catalogue_tests}
+mkdir -p "$OUT"
+FLAGS="-std=c++20 -O2 -Wall -Wextra"
+SOURCES=$(ls ../*.cpp | grep -v '/main\.cpp$')
+
+for test in *_test.cpp; do
+    name=$(basename "$test" .cpp)
+    g++ $FLAGS "$test" $SOURCES -o "$OUT/$name" -lpthread
+    "$OUT/$name"
+done
+
+g++ $FLAGS ../*.cpp -o "$OUT/transport_catalogue" -lpthread
+g++ $FLAGS -DTRANSPORT_MICRO_COORDINATES ../*.cpp -o "$OUT/transport_catalogue_micro" -lpthread
+for document in data/*.json; do
+    "$OUT/transport_catalogue" < "$document" > "$OUT/doubles.out"
+    "$OUT/transport_catalogue_micro" < "$document" > "$OUT/micro.out"
+    if ! cmp -s "$OUT/doubles.out" "$OUT/micro.out"; then
+        echo "FAILED: $document: answers differ between coordinate storage modes"
+        diff "$OUT/doubles.out" "$OUT/micro.out" | head -20
+        exit 1
+    fi
+    expected="${document%.json}.expected"
+    if [ -f "$expected" ] && ! cmp -s "$OUT/doubles.out" "$expected"; then
+        echo "FAILED: $document: answers differ from $expected"
+        exit 1
+    fi
+done
+echo "coordinate storage modes: OK"
@@ -1,97 +1,943 @@
 #include "transport_catalogue.h"
 //transport_catalogue.h
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <tuple>
 namespace transport {
-    void TransportCatalogue::AddStop(const std::string& name, geo::Coordinates coordinates) {
-        stops_.push_back({name, coordinates});
-        const auto& stop = stops_.back();
-        stop_name_to_stop_[stop.name] = &stop;
+    namespace {
+        // Сколько маршрутов поток берёт за раз в GetNetworkStats
+        constexpr size_t STATS_BLOCK = 64;
+
+        template <typename T>
+        bool NameLess(const T* lhs, const T* rhs) {
+            return lhs->name < rhs->name;
+        }
+
+        template <typename T>
+        void InsertSortedByName(std::vector<const T*>& sorted, const T* item) {
+            sorted.insert(std::lower_bound(sorted.begin(), sorted.end(), item, NameLess<T>), item);
+        }
+
+        // Имена с общим префиксом в отсортированном массиве идут подряд
+        template <typename T>
+        std::vector<const T*> FindByPrefix(const std::vector<const T*>& sorted, std::string_view prefix, size_t count) {
+            auto it = std::lower_bound(sorted.begin(), sorted.end(), prefix,
+                                       [](const T* item, std::string_view value) { return item->name < value; });
+            std::vector<const T*> result;
+            for (; it != sorted.end() && result.size() < count && (*it)->name.starts_with(prefix); ++it) {
+                result.push_back(*it);
+            }
+            return result;
+        }
+
+        // Если из некольцевого пути выброшена неописанная конечная, то в
+        // отражённом пути рядом остаются две копии последней описанной остановки
+        bool RepeatsTurnaround(std::span<const Stop* const> stops, bool is_roundtrip) {
+            return !is_roundtrip && stops.size() > 1 && stops.back() == nullptr
+                && std::any_of(stops.begin(), stops.end(), [](const Stop* stop) { return stop != nullptr; });
+        }
+
+        // Участок между соседними остановками пути. Пара остановок, которую
+        // проезжают несколько маршрутов, считается в Freeze один раз на все маршруты
+        struct Segment {
+            int road_meters = 0;
+            double geo_meters = 0.0;
+        };
+
+        using DistanceRecord = CatalogueImage::DistanceRecord;
+
+        bool DistanceLess(const DistanceRecord& lhs, const DistanceRecord& rhs) {
+            return std::tie(lhs.from, lhs.to) < std::tie(rhs.from, rhs.to);
+        }
+
+        uint64_t DistanceKey(uint32_t from, uint32_t to) {
+            return static_cast<uint64_t>(from) << 32 | to;
+        }
+
+        void CheckImage(bool condition) {
+            if (!condition) {
+                throw std::invalid_argument("Inconsistent catalogue image");
+            }
+        }
+
+        uint32_t CheckedU32(size_t value) {
+            if (value > std::numeric_limits<uint32_t>::max()) {
+                throw std::length_error("Transport catalogue is too large for an image");
+            }
+            return static_cast<uint32_t>(value);
+        }
+
+        // Совершенный хеш-индекс, в котором позиция имени — номер записи
+        perfect_hash::StringIndex BuildNameIndex(const std::unordered_map<std::string_view, uint32_t>& ids) {
+            std::vector<std::string_view> names;
+            std::vector<uint32_t> positions;
+            names.reserve(ids.size());
+            positions.reserve(ids.size());
+            for (const auto& [name, id] : ids) {
+                names.push_back(name);
+                positions.push_back(id);
+            }
+            return perfect_hash::StringIndex(names, positions);
+        }
+
+        // Записи в порядке, заданном номерами
+        template <typename T>
+        std::vector<const T*> ByIds(std::span<const uint32_t> ids, const std::vector<const T*>& items) {
+            CheckImage(ids.size() == items.size());
+            std::vector<const T*> result;
+            result.reserve(ids.size());
+            for (uint32_t id : ids) {
+                CheckImage(id < items.size());
+                result.push_back(items[id]);
+            }
+            return result;
+        }
+
+        // Номера остановок и маршрутов, у которых срезы лежат подряд, должны
+        // идти по возрастанию: смещения — неубывающие и не выходят за массив
+        bool IsOffsetTable(std::span<const uint32_t> offsets, size_t size) {
+            return !offsets.empty() && offsets.front() == 0 && offsets.back() == size
+                && std::is_sorted(offsets.begin(), offsets.end());
+        }
+
+        // Таблица, которую версия меняет: общая с другими версиями сначала копируется.
+        // Счётчик ссылок может только устареть в большую сторону (другая
+        // версия освобождена), и тогда таблица просто скопируется лишний раз
+        template <typename T>
+        T& Mutable(std::shared_ptr<T>& table) {
+            if (table.use_count() > 1) {
+                table = std::make_shared<T>(*table);
+            }
+            return *table;
+        }
+
+        // Заменяет в упорядоченном по названию массиве объект с тем же именем
+        template <typename T>
+        void ReplaceSortedByName(std::vector<const T*>& sorted, const T* old_item, const T* item) {
+            auto [first, last] = std::equal_range(sorted.begin(), sorted.end(), old_item, NameLess<T>);
+            *std::find(first, last, old_item) = item;
+        }
+
+        // Память маршрута в арене, без имени
+        size_t BusBytes(const Bus& bus) {
+            return sizeof(Bus) + bus.stops.size() * sizeof(const Stop*) + bus.road_prefix.size() * sizeof(double);
+        }
+
+        // Записи живут в монотонной арене, деструкторы им не вызываются
+        static_assert(std::is_trivially_destructible_v<Stop> && std::is_trivially_destructible_v<Bus>);
+
+        // Массивы образа, собранного MakeImage
+        struct ImageStorage {
+            std::string strings;
+            std::vector<CatalogueImage::StopRecord> stops;
+            std::vector<CatalogueImage::BusRecord> buses;
+            std::vector<uint32_t> route_stops;
+            std::vector<double> road_prefix;
+            std::vector<DistanceRecord> distances;
+            std::vector<uint32_t> stops_by_name;
+            std::vector<uint32_t> buses_by_name;
+            perfect_hash::StringIndex stop_index;
+            perfect_hash::StringIndex bus_index;
+            std::vector<uint32_t> stop_bus_offsets;
+            std::vector<uint32_t> stop_bus_ids;
+            spatial::StopGrid grid;
+        };
+    }
+
+    TransportCatalogue::TransportCatalogue()
+        : arena_(std::make_shared<std::pmr::monotonic_buffer_resource>())
+        , all_stops_(std::make_shared<std::vector<const Stop*>>())
+        , all_buses_(std::make_shared<std::vector<const Bus*>>())
+        , stop_index_(std::make_shared<perfect_hash::StringIndex>())
+        , bus_index_(std::make_shared<perfect_hash::StringIndex>())
+        , stop_grid_(std::make_shared<spatial::StopGrid>())
+        , stops_by_name_(std::make_shared<std::vector<const Stop*>>())
+        , buses_by_name_(std::make_shared<std::vector<const Bus*>>()) {
     }
 
-    void TransportCatalogue::AddBus(const std::string& name,const std::vector<std::string>& stop_names,bool is_roundtrip) {
-        Bus bus;
-        bus.name = name;
-        bus.is_roundtrip = is_roundtrip;
+    TransportCatalogue::TransportCatalogue(const CatalogueImage& image)
+        : TransportCatalogue() {
+        if (image.storage) {
+            storages_.push_back(image.storage);
+        }
+        external_bytes_ = image.strings;
+        const auto name_of = [&image](CatalogueImage::NameRef name) {
+            CheckImage(name.offset <= image.strings.size() && name.size <= image.strings.size() - name.offset);
+            return image.strings.substr(name.offset, name.size);
+        };
 
-        for (const auto& stop_name : stop_names) {
-            if (auto it = stop_name_to_stop_.find(stop_name); it != stop_name_to_stop_.end()) {
-                bus.stops.push_back(it->second);
+        auto& all_stops = *all_stops_;
+        all_stops.reserve(image.stops.size());
+        std::vector<std::string_view> stop_names;
+        stop_names.reserve(image.stops.size());
+        for (const auto& record : image.stops) {
+            all_stops.push_back(NewStop(name_of(record.name), StopCoordinates(geo::Coordinates{record.lat, record.lng}),
+                                        static_cast<uint32_t>(all_stops.size())));
+            stop_names.push_back(all_stops.back()->name);
+        }
 
-                stop_to_buses_[it->second].insert(bus.name);
+        // Пути всех маршрутов лежат в арене одним массивом, как в route_stops
+        std::pmr::polymorphic_allocator<const Stop*> alloc(arena_.get());
+        const Stop** route_stops = alloc.allocate(image.route_stops.size());
+        for (size_t i = 0; i < image.route_stops.size(); ++i) {
+            CheckImage(image.route_stops[i] < all_stops.size());
+            route_stops[i] = all_stops[image.route_stops[i]];
+        }
+
+        auto& all_buses = *all_buses_;
+        all_buses.reserve(image.buses.size());
+        std::vector<std::string_view> bus_names;
+        bus_names.reserve(image.buses.size());
+        for (const auto& record : image.buses) {
+            CheckImage(record.stops_offset <= image.route_stops.size()
+                       && record.stops_count <= image.route_stops.size() - record.stops_offset);
+            std::pmr::polymorphic_allocator<> bus_alloc(arena_.get());
+            Bus* bus = bus_alloc.new_object<Bus>();
+            bus->id = static_cast<uint32_t>(all_buses.size());
+            bus->name = name_of(record.name);
+            bus->stops = {route_stops + record.stops_offset, record.stops_count};
+            bus->is_roundtrip = record.is_roundtrip != 0;
+            bus->repeats_turnaround = record.repeats_turnaround != 0;
+            const size_t route_size = bus->Route().size();
+            CheckImage(record.prefix_offset <= image.road_prefix.size()
+                       && route_size <= image.road_prefix.size() - record.prefix_offset);
+            bus->road_prefix = image.road_prefix.subspan(record.prefix_offset, route_size);
+            bus->geo_length = record.geo_length;
+            all_buses.push_back(bus);
+            bus_names.push_back(bus->name);
+        }
+
+        try {
+            stop_index_ = std::make_shared<perfect_hash::StringIndex>(stop_names, image.stop_index);
+            bus_index_ = std::make_shared<perfect_hash::StringIndex>(bus_names, image.bus_index);
+        } catch (const std::invalid_argument&) {
+            CheckImage(false);
+        }
+        *stops_by_name_ = ByIds(image.stops_by_name, all_stops);
+        *buses_by_name_ = ByIds(image.buses_by_name, all_buses);
+        CheckImage(std::is_sorted(stops_by_name_->begin(), stops_by_name_->end(), NameLess<Stop>)
+                   && std::is_sorted(buses_by_name_->begin(), buses_by_name_->end(), NameLess<Bus>));
+
+        CheckImage(std::all_of(image.distances.begin(), image.distances.end(), [&](const DistanceRecord& record) {
+            return record.from < all_stops.size() && record.to < all_stops.size();
+        }) && std::is_sorted(image.distances.begin(), image.distances.end(), DistanceLess));
+        distances_ = image.distances;
+
+        CheckImage(image.stop_bus_offsets.size() == all_stops.size() + 1
+                   && IsOffsetTable(image.stop_bus_offsets, image.stop_bus_ids.size())
+                   && std::all_of(image.stop_bus_ids.begin(), image.stop_bus_ids.end(),
+                                  [&](uint32_t id) { return id < all_buses.size(); }));
+        stop_bus_offsets_ = image.stop_bus_offsets;
+        stop_bus_ids_ = image.stop_bus_ids;
+
+        stop_grid_ = std::make_shared<spatial::StopGrid>(image.grid, all_stops.size());
+        live_bytes_ = CountLiveBytes();
+        frozen_ = true;
+    }
+
+    std::string_view TransportCatalogue::Intern(std::string_view str) {
+        if (str.empty()) return {};
+        // Строки из подключённого хранилища используем без копирования
+        const auto begin = reinterpret_cast<std::uintptr_t>(external_bytes_.data());
+        const auto ptr = reinterpret_cast<std::uintptr_t>(str.data());
+        if (ptr >= begin && ptr + str.size() <= begin + external_bytes_.size()) {
+            return str;
+        }
+        if (auto it = interned_.find(str); it != interned_.end()) {
+            return *it;
+        }
+        char* data = static_cast<char*>(arena_->allocate(str.size(), alignof(char)));
+        std::memcpy(data, str.data(), str.size());
+        const std::string_view interned(data, str.size());
+        if (!frozen_) {
+            interned_.insert(interned);
+        }
+        return interned;
+    }
+
+    void TransportCatalogue::Reserve(size_t stop_count, size_t bus_count, size_t distance_count) {
+        CheckNotFrozen();
+        stop_ids_.reserve(stop_count);
+        bus_ids_.reserve(bus_count);
+        all_stops_->reserve(stop_count);
+        all_buses_->reserve(bus_count);
+        loading_distances_.reserve(distance_count);
+    }
+
+    const Stop* TransportCatalogue::AddStop(std::string_view name, geo::Coordinates coordinates) {
+        CheckNotFrozen();
+        return InsertStop(name, coordinates);
+    }
+
+    void TransportCatalogue::AddBus(std::string_view name,const std::vector<std::string>& stop_names,bool is_roundtrip) {
+        AddBus(name, ResolveStops(stop_names), is_roundtrip);
+    }
+
+    void TransportCatalogue::AddBus(std::string_view name, std::span<const Stop* const> stops, bool is_roundtrip) {
+        CheckNotFrozen();
+        InsertBus(name, stops, is_roundtrip);
+    }
+
+    Stop* TransportCatalogue::NewStop(std::string_view name, StopCoordinates coordinates, uint32_t id) {
+        std::pmr::polymorphic_allocator<> alloc(arena_.get());
+        return alloc.new_object<Stop>(Stop{name, coordinates, id});
+    }
+
+    const Stop* TransportCatalogue::InsertStop(std::string_view name, geo::Coordinates coordinates) {
+        const auto id = static_cast<uint32_t>(all_stops_->size());
+        const Stop* stop = NewStop(Intern(name), StopCoordinates(coordinates), id);
+        stop_ids_[stop->name] = id;
+        Mutable(all_stops_).push_back(stop);
+        if (frozen_) {
+            InsertSortedByName(Mutable(stops_by_name_), stop);
+            Mutable(stop_grid_).Insert(stop, *all_stops_);
+            live_bytes_ += sizeof(Stop) + stop->name.size();
+        }
+        return stop;
+    }
+
+    Bus* TransportCatalogue::NewBus(uint32_t id, std::string_view name, std::span<const Stop* const> stops, bool is_roundtrip) {
+        std::pmr::polymorphic_allocator<> alloc(arena_.get());
+        Bus* bus = alloc.new_object<Bus>();
+        bus->id = id;
+        bus->name = name;
+        bus->is_roundtrip = is_roundtrip;
+        bus->repeats_turnaround = RepeatsTurnaround(stops, is_roundtrip);
+        bus->stops = StoreStops(stops);
+        return bus;
+    }
+
+    // Маршрут, добавленный после Freeze, получает длины в Apply вместе с
+    // остальными изменёнными маршрутами
+    Bus* TransportCatalogue::InsertBus(std::string_view name, std::span<const Stop* const> stops, bool is_roundtrip) {
+        const auto id = static_cast<uint32_t>(all_buses_->size());
+        Bus* bus = NewBus(id, Intern(name), stops, is_roundtrip);
+        bus_ids_[bus->name] = id;
+        Mutable(all_buses_).push_back(bus);
+        if (frozen_) {
+            for (const Stop* stop : bus->stops) {
+                auto& ids = GetUpdatedBusIds(stop->id);
+                if (auto it = std::lower_bound(ids.begin(), ids.end(), id); it == ids.end() || *it != id) {
+                    ids.insert(it, id);
+                }
             }
+            InsertSortedByName<Bus>(Mutable(buses_by_name_), bus);
+            live_bytes_ += bus->name.size();
+        } else {
+            loading_buses_.push_back(bus);
         }
+        return bus;
+    }
+
+    void TransportCatalogue::ReplaceStop(const Stop* stop) {
+        auto& all_stops = Mutable(all_stops_);
+        const Stop* old_stop = all_stops[stop->id];
+        all_stops[stop->id] = stop;
+        ReplaceSortedByName(Mutable(stops_by_name_), old_stop, stop);
+        garbage_bytes_ += sizeof(Stop);
+    }
+
+    void TransportCatalogue::ReplaceBus(const Bus* bus) {
+        auto& all_buses = Mutable(all_buses_);
+        const Bus* old_bus = all_buses[bus->id];
+        all_buses[bus->id] = bus;
+        ReplaceSortedByName(Mutable(buses_by_name_), old_bus, bus);
+        live_bytes_ -= BusBytes(*old_bus);
+        garbage_bytes_ += BusBytes(*old_bus);
+    }
 
-        buses_.push_back(std::move(bus));
-        const auto& inserted_bus = buses_.back();
-        bus_name_to_bus_[inserted_bus.name] = &inserted_bus;
+    std::span<const Stop* const> TransportCatalogue::StoreStops(std::span<const Stop* const> stops) {
+        const auto is_defined = [](const Stop* stop) { return stop != nullptr; };
+        const size_t count = std::count_if(stops.begin(), stops.end(), is_defined);
+        std::pmr::polymorphic_allocator<const Stop*> alloc(arena_.get());
+        const Stop** stored_stops = alloc.allocate(count);
+        std::copy_if(stops.begin(), stops.end(), stored_stops, is_defined);
+        return {stored_stops, count};
     }
+
+    std::vector<const Stop*> TransportCatalogue::ResolveStops(const std::vector<std::string>& stop_names) const {
+        std::vector<const Stop*> stops;
+        stops.reserve(stop_names.size());
+        for (const auto& stop_name : stop_names) {
+            stops.push_back(FindStop(stop_name));
+        }
+        return stops;
+    }
+
+    void TransportCatalogue::IndexRoute(Bus& bus) {
+        const RouteView route = bus.Route();
+        if (route.empty()) {
+            bus.road_prefix = {};
+            bus.geo_length = 0.0;
+            return;
+        }
+        std::pmr::polymorphic_allocator<double> alloc(arena_.get());
+        double* prefix = alloc.allocate(route.size());
+        double geo_length = 0.0;
+        prefix[0] = 0.0;
+        auto it = route.begin();
+        for (size_t i = 0; i + 1 < route.size(); ++i) {
+            const Stop* from = *it;
+            const Stop* to = *++it;
+            prefix[i + 1] = prefix[i] + GetDistance(from, to);
+            geo_length += ComputeDistance(from->coordinates, to->coordinates);
+        }
+        bus.road_prefix = {prefix, route.size()};
+        bus.geo_length = geo_length;
+    }
+
+    size_t TransportCatalogue::CountLiveBytes() const {
+        size_t bytes = 0;
+        for (const Stop* stop : *all_stops_) {
+            bytes += sizeof(Stop) + stop->name.size();
+        }
+        for (const Bus* bus : *all_buses_) {
+            bytes += bus->name.size() + BusBytes(*bus);
+        }
+        return bytes;
+    }
+
+    std::span<const uint32_t> TransportCatalogue::GetBusIds(uint32_t stop_id) const {
+        if (auto it = updated_stop_buses_.find(stop_id); it != updated_stop_buses_.end()) {
+            return it->second;
+        }
+        if (stop_id + 1 >= stop_bus_offsets_.size()) {
+            return {};
+        }
+        return stop_bus_ids_.subspan(stop_bus_offsets_[stop_id], stop_bus_offsets_[stop_id + 1] - stop_bus_offsets_[stop_id]);
+    }
+
+    std::vector<uint32_t>& TransportCatalogue::GetUpdatedBusIds(uint32_t stop_id) {
+        if (auto it = updated_stop_buses_.find(stop_id); it != updated_stop_buses_.end()) {
+            return it->second;
+        }
+        const std::span<const uint32_t> ids = GetBusIds(stop_id);
+        return updated_stop_buses_.emplace(stop_id, std::vector<uint32_t>(ids.begin(), ids.end())).first->second;
+    }
+
+    template <typename T>
+    std::span<const T> TransportCatalogue::CopyToArena(const std::vector<T>& items) {
+        std::pmr::polymorphic_allocator<T> alloc(arena_.get());
+        T* data = alloc.allocate(items.size());
+        std::copy(items.begin(), items.end(), data);
+        return {data, items.size()};
+    }
+
     void TransportCatalogue::SetDistance(const Stop* from, const Stop* to, int distance){
-        distance_[{from,to}] = distance;
+        CheckNotFrozen();
+        loading_distances_[{from,to}] = distance;
     }
+
     const Stop* TransportCatalogue::FindStop(std::string_view name) const {
-        auto it = stop_name_to_stop_.find(name);
-        return it != stop_name_to_stop_.end() ? it->second : nullptr;
+        if (frozen_) {
+            const size_t pos = stop_index_->Find(name);
+            if (pos != perfect_hash::StringIndex::npos) return (*all_stops_)[pos];
+            if (stop_ids_.empty()) return nullptr;
+        }
+        auto it = stop_ids_.find(name);
+        return it != stop_ids_.end() ? (*all_stops_)[it->second] : nullptr;
     }
+
+    const int* TransportCatalogue::FindDistance(uint32_t from, uint32_t to) const {
+        if (!updated_distances_.empty()) {
+            if (auto it = updated_distances_.find(DistanceKey(from, to)); it != updated_distances_.end()) {
+                return &it->second;
+            }
+        }
+        auto it = std::lower_bound(distances_.begin(), distances_.end(), DistanceRecord{from, to, 0}, DistanceLess);
+        return it != distances_.end() && it->from == from && it->to == to ? &it->meters : nullptr;
+    }
+
     int TransportCatalogue::GetDistance(const Stop* from , const Stop* to) const{
-        auto it_from = distance_.find({from,to});
-        if (it_from != distance_.end()) return it_from -> second;
-        auto it_to = distance_.find({to,from});
-        if (it_to != distance_.end()) return it_to -> second;
+        if (frozen_) {
+            if (const int* distance = FindDistance(from->id, to->id)) return *distance;
+            if (const int* distance = FindDistance(to->id, from->id)) return *distance;
+            return 0;
+        }
+        auto it_from = loading_distances_.find({from,to});
+        if (it_from != loading_distances_.end()) return it_from -> second;
+        auto it_to = loading_distances_.find({to,from});
+        if (it_to != loading_distances_.end()) return it_to -> second;
         return 0;
     }
     const Bus* TransportCatalogue::FindBus(std::string_view name) const {
-        auto it = bus_name_to_bus_.find(name);
-        return it != bus_name_to_bus_.end() ? it->second : nullptr;
+        if (frozen_) {
+            const size_t pos = bus_index_->Find(name);
+            if (pos != perfect_hash::StringIndex::npos) return (*all_buses_)[pos];
+            if (bus_ids_.empty()) return nullptr;
+        }
+        auto it = bus_ids_.find(name);
+        return it != bus_ids_.end() ? (*all_buses_)[it->second] : nullptr;
     }
 
     transport::BusInfo TransportCatalogue::GetBusInfo(std::string_view name) const {
+        return GetBusInfo(FindBus(name));
+    }
+
+    transport::BusInfo TransportCatalogue::GetBusInfo(const Bus* bus) const {
         BusInfo info;
-        auto it = bus_name_to_bus_.find(name);
-        if (it == bus_name_to_bus_.end()) return info;
+        if (!bus) return info;
 
-        const Bus* bus = it->second;
-        info.total_stops = bus->stops.size();
+        const RouteView route = bus->Route();
+        info.total_stops = route.size();
 
-        std::unordered_set<const Stop*> unique_stops(bus->stops.begin(), bus->stops.end());
-        info.unique_stops = unique_stops.size();
+        std::vector<uint32_t> stop_ids;
+        stop_ids.reserve(bus->stops.size());
+        for (const Stop* stop : bus->stops) {
+            stop_ids.push_back(stop->id);
+        }
+        std::sort(stop_ids.begin(), stop_ids.end());
+        info.unique_stops = std::unique(stop_ids.begin(), stop_ids.end()) - stop_ids.begin();
 
         double geo_route_lenght = 0.0;
         info.route_length = 0.0;
-        for (size_t i = 1; i < bus->stops.size(); ++i) {
-            const Stop* from = bus -> stops[i-1];
-            const Stop* to = bus -> stops[i];
-
-            info.route_length+=GetDistance(from,to);
-            geo_route_lenght+=ComputeDistance(from-> coordinates, to-> coordinates);
+        if (frozen_) {
+            // Длины посчитаны в Freeze по таблице участков
+            info.route_length = bus->road_prefix.empty() ? 0.0 : bus->road_prefix.back();
+            geo_route_lenght = bus->geo_length;
+        } else {
+            for (size_t i = 1; i < route.size(); ++i) {
+                info.route_length += GetDistance(route[i - 1], route[i]);
+                geo_route_lenght += ComputeDistance(route[i - 1]->coordinates, route[i]->coordinates);
+            }
         }
         info.curvature = (geo_route_lenght == 0) ? 0.0 : info.route_length  / geo_route_lenght;
         info.exists = true;
         return info;
     }
-    const std::deque<const Bus*>& TransportCatalogue::GetAllBuses() const {
-      all_buses_.clear();
-      for (const Bus& bus : buses_) {
-          all_buses_.push_back(&bus);
-      }
-      return all_buses_;
-    }
-    const std::deque<const Stop*>& TransportCatalogue::GetAllStops() const {
-      all_stops_.clear();
-      for (const auto& stop : stops_) {
-          all_stops_.push_back(&stop);
-      }
-      return all_stops_;
-  }
-  const std::set<std::string>& TransportCatalogue::GetBusesForStop(std::string_view stop_name) const {
+
+    NetworkStats TransportCatalogue::GetNetworkStats(bool with_buses) const {
+        const std::vector<const Bus*>& buses_by_name = *buses_by_name_;
+        std::vector<BusStats> buses(buses_by_name.size());
+
+        // Потоки разбирают маршруты блоками: длины маршрутов сильно различаются
+        std::atomic<size_t> next_block = 0;
+        auto worker = [&] {
+            for (size_t begin = next_block.fetch_add(STATS_BLOCK); begin < buses.size();
+                 begin = next_block.fetch_add(STATS_BLOCK)) {
+                const size_t end = std::min(begin + STATS_BLOCK, buses.size());
+                for (size_t i = begin; i < end; ++i) {
+                    buses[i] = {buses_by_name[i], GetBusInfo(buses_by_name[i])};
+                }
+            }
+        };
+        const size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                                     (buses.size() + STATS_BLOCK - 1) / STATS_BLOCK);
+        {
+            std::vector<std::jthread> threads;
+            for (size_t i = 1; i < thread_count; ++i) {
+                threads.emplace_back(worker);
+            }
+            worker();
+        }
+
+        NetworkStats stats;
+        stats.bus_count = buses.size();
+        stats.stop_count = all_stops_->size();
+        int curved_buses = 0;
+        for (const BusStats& bus : buses) {
+            stats.total_stops += bus.info.total_stops;
+            stats.total_route_length += bus.info.route_length;
+            if (bus.bus->geo_length > 0.0) {
+                stats.mean_curvature += bus.info.curvature;
+                ++curved_buses;
+            }
+        }
+        if (curved_buses > 0) {
+            stats.mean_curvature /= curved_buses;
+        }
+        if (with_buses) {
+            stats.buses = std::move(buses);
+        }
+        return stats;
+    }
+
+    const std::vector<const Bus*>& TransportCatalogue::GetAllBuses() const {
+        return *all_buses_;
+    }
+    const std::vector<const Stop*>& TransportCatalogue::GetAllStops() const {
+        return *all_stops_;
+    }
+    const std::vector<const Bus*>& TransportCatalogue::GetBusesSortedByName() const {
+        return *buses_by_name_;
+    }
+    std::vector<const Bus*> TransportCatalogue::GetBusesForStop(std::string_view stop_name) const {
+        std::vector<const Bus*> buses;
         const Stop* stop = FindStop(stop_name);
-        static const std::set<std::string> empty_result;
         if (!stop) {
-            return empty_result;
+            return buses;
         }
+        for (uint32_t id : GetBusIds(stop->id)) {
+            buses.push_back((*all_buses_)[id]);
+        }
+        std::sort(buses.begin(), buses.end(), NameLess<Bus>);
+        return buses;
+    }
+    std::vector<const Bus*> TransportCatalogue::GetCommonBuses(std::span<const Stop* const> stops) const {
+        std::vector<const Bus*> buses;
+        if (stops.empty()) {
+            return buses;
+        }
+        // Множества строятся по спискам номеров; списки частых остановок
+        // сразу становятся битовыми масками
+        const auto universe = static_cast<uint32_t>(all_buses_->size());
+        std::vector<id_set::IdSet> sets;
+        sets.reserve(stops.size());
+        for (const Stop* stop : stops) {
+            const std::span<const uint32_t> ids = GetBusIds(stop->id);
+            sets.emplace_back(std::vector<uint32_t>(ids.begin(), ids.end()), universe);
+        }
+        // Начинаем с самого маленького множества, чтобы промежуточные были короче
+        std::sort(sets.begin(), sets.end(), [](const id_set::IdSet& lhs, const id_set::IdSet& rhs) {
+            return lhs.Size() < rhs.Size();
+        });
 
-        if (auto it = stop_to_buses_.find(stop); it != stop_to_buses_.end()) {
-            return it->second;
+        id_set::IdSet common = sets.size() > 1 ? sets[0].Intersect(sets[1]) : sets[0];
+        for (size_t i = 2; i < sets.size() && !common.Empty(); ++i) {
+            common = common.Intersect(sets[i]);
+        }
+        for (uint32_t id : common.ToVector()) {
+            buses.push_back((*all_buses_)[id]);
+        }
+        std::sort(buses.begin(), buses.end(), NameLess<Bus>);
+        return buses;
+    }
+    std::vector<const Stop*> TransportCatalogue::SearchStops(std::string_view prefix, size_t count) const {
+        return FindByPrefix(*stops_by_name_, prefix, count);
+    }
+    std::vector<const Bus*> TransportCatalogue::SearchBuses(std::string_view prefix, size_t count) const {
+        return FindByPrefix(*buses_by_name_, prefix, count);
+    }
+    std::vector<spatial::NearbyStop> TransportCatalogue::FindNearestStops(geo::Coordinates center, size_t count) const {
+        return stop_grid_->FindNearest(center, count, *all_stops_);
+    }
+    std::vector<spatial::NearbyStop> TransportCatalogue::FindStopsWithin(geo::Coordinates center, double radius) const {
+        return stop_grid_->FindWithin(center, radius, *all_stops_);
+    }
+
+    void TransportCatalogue::Freeze() {
+        if (frozen_) return;
+
+        {
+            std::unordered_map<std::pair<const Stop*, const Stop*>, Segment, PairHash> segments;
+            std::pmr::polymorphic_allocator<double> alloc(arena_.get());
+            for (Bus* bus : loading_buses_) {
+                const RouteView route = bus->Route();
+                if (route.empty()) continue;
+                double* prefix = alloc.allocate(route.size());
+                double geo_length = 0.0;
+                prefix[0] = 0.0;
+                auto it = route.begin();
+                for (size_t i = 0; i + 1 < route.size(); ++i) {
+                    const Stop* from = *it;
+                    const Stop* to = *++it;
+                    auto [segment, inserted] = segments.try_emplace({from, to});
+                    if (inserted) {
+                        segment->second = {GetDistance(from, to), ComputeDistance(from->coordinates, to->coordinates)};
+                    }
+                    prefix[i + 1] = prefix[i] + segment->second.road_meters;
+                    geo_length += segment->second.geo_meters;
+                }
+                bus->road_prefix = {prefix, route.size()};
+                bus->geo_length = geo_length;
+            }
+        }
+        std::vector<Bus*>().swap(loading_buses_);
+
+        const std::vector<const Stop*>& all_stops = *all_stops_;
+        const std::vector<const Bus*>& all_buses = *all_buses_;
+        stop_grid_ = std::make_shared<spatial::StopGrid>(all_stops);
+
+        // Маршруты перебираются по возрастанию номера, поэтому списки
+        // номеров получаются отсортированными; повторный заезд маршрута на
+        // остановку отсекается по последнему записанному номеру
+        {
+            constexpr uint32_t NO_BUS = std::numeric_limits<uint32_t>::max();
+            std::vector<uint32_t> offsets(all_stops.size() + 1, 0);
+            std::vector<uint32_t> last_bus(all_stops.size(), NO_BUS);
+            for (const Bus* bus : all_buses) {
+                for (const Stop* stop : bus->stops) {
+                    if (last_bus[stop->id] != bus->id) {
+                        last_bus[stop->id] = bus->id;
+                        ++offsets[stop->id + 1];
+                    }
+                }
+            }
+            for (size_t i = 1; i < offsets.size(); ++i) {
+                offsets[i] += offsets[i - 1];
+            }
+            std::vector<uint32_t> ids(offsets.back());
+            std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+            std::fill(last_bus.begin(), last_bus.end(), NO_BUS);
+            for (const Bus* bus : all_buses) {
+                for (const Stop* stop : bus->stops) {
+                    if (last_bus[stop->id] != bus->id) {
+                        last_bus[stop->id] = bus->id;
+                        ids[next[stop->id]++] = bus->id;
+                    }
+                }
+            }
+            stop_bus_offsets_ = CopyToArena(offsets);
+            stop_bus_ids_ = CopyToArena(ids);
+        }
+
+        {
+            std::vector<DistanceRecord> distances;
+            distances.reserve(loading_distances_.size());
+            for (const auto& [stops, meters] : loading_distances_) {
+                distances.push_back({stops.first->id, stops.second->id, meters});
+            }
+            std::sort(distances.begin(), distances.end(), DistanceLess);
+            distances_ = CopyToArena(distances);
+        }
+
+        *stops_by_name_ = all_stops;
+        std::sort(stops_by_name_->begin(), stops_by_name_->end(), NameLess<Stop>);
+        *buses_by_name_ = all_buses;
+        std::sort(buses_by_name_->begin(), buses_by_name_->end(), NameLess<Bus>);
+
+        // Имя, описанное дважды, указывает на последнее описание
+        stop_index_ = std::make_shared<perfect_hash::StringIndex>(BuildNameIndex(stop_ids_));
+        bus_index_ = std::make_shared<perfect_hash::StringIndex>(BuildNameIndex(bus_ids_));
+        std::unordered_map<std::string_view, uint32_t>().swap(stop_ids_);
+        std::unordered_map<std::string_view, uint32_t>().swap(bus_ids_);
+        std::unordered_set<std::string_view>().swap(interned_);
+        decltype(loading_distances_)().swap(loading_distances_);
+
+        live_bytes_ = CountLiveBytes();
+        frozen_ = true;
+    }
+
+    CatalogueImage TransportCatalogue::MakeImage() const {
+        if (!frozen_) {
+            throw std::logic_error("Transport catalogue is not frozen");
+        }
+        auto storage = std::make_shared<ImageStorage>();
+        const auto add_name = [&strings = storage->strings](std::string_view name) {
+            const CatalogueImage::NameRef ref{CheckedU32(strings.size()), CheckedU32(name.size())};
+            strings.append(name);
+            return ref;
+        };
+
+        storage->stops.reserve(all_stops_->size());
+        for (const Stop* stop : *all_stops_) {
+            const geo::Coordinates coordinates = geo::ToDegrees(stop->coordinates);
+            storage->stops.push_back({add_name(stop->name), coordinates.lat, coordinates.lng});
+        }
+        storage->buses.reserve(all_buses_->size());
+        for (const Bus* bus : *all_buses_) {
+            storage->buses.push_back({add_name(bus->name), CheckedU32(storage->route_stops.size()),
+                                      CheckedU32(bus->stops.size()), CheckedU32(storage->road_prefix.size()),
+                                      bus->is_roundtrip, bus->repeats_turnaround, 0, bus->geo_length});
+            for (const Stop* stop : bus->stops) {
+                storage->route_stops.push_back(stop->id);
+            }
+            storage->road_prefix.insert(storage->road_prefix.end(), bus->road_prefix.begin(), bus->road_prefix.end());
+        }
+        CheckedU32(storage->route_stops.size());
+        CheckedU32(storage->road_prefix.size());
+
+        // Расстояния, заданные через ApplyUpdate, заменяют прежние
+        storage->distances.reserve(distances_.size() + updated_distances_.size());
+        for (const DistanceRecord& record : distances_) {
+            storage->distances.push_back({record.from, record.to, *FindDistance(record.from, record.to)});
         }
+        for (const auto& [key, meters] : updated_distances_) {
+            const DistanceRecord record{static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key), meters};
+            if (!std::binary_search(distances_.begin(), distances_.end(), record, DistanceLess)) {
+                storage->distances.push_back(record);
+            }
+        }
+        std::sort(storage->distances.begin(), storage->distances.end(), DistanceLess);
+
+        for (const Stop* stop : *stops_by_name_) {
+            storage->stops_by_name.push_back(stop->id);
+        }
+        for (const Bus* bus : *buses_by_name_) {
+            storage->buses_by_name.push_back(bus->id);
+        }
+        // Без новых имён индексы справочника подходят и образу
+        if (stop_ids_.empty()) {
+            storage->stop_index = *stop_index_;
+        } else {
+            std::unordered_map<std::string_view, uint32_t> ids;
+            for (const Stop* stop : *all_stops_) {
+                ids[stop->name] = stop->id;
+            }
+            storage->stop_index = BuildNameIndex(ids);
+        }
+        if (bus_ids_.empty()) {
+            storage->bus_index = *bus_index_;
+        } else {
+            std::unordered_map<std::string_view, uint32_t> ids;
+            for (const Bus* bus : *all_buses_) {
+                ids[bus->name] = bus->id;
+            }
+            storage->bus_index = BuildNameIndex(ids);
+        }
+
+        storage->stop_bus_offsets.reserve(all_stops_->size() + 1);
+        storage->stop_bus_offsets.push_back(0);
+        for (const Stop* stop : *all_stops_) {
+            const std::span<const uint32_t> ids = GetBusIds(stop->id);
+            storage->stop_bus_ids.insert(storage->stop_bus_ids.end(), ids.begin(), ids.end());
+            storage->stop_bus_offsets.push_back(CheckedU32(storage->stop_bus_ids.size()));
+        }
+        storage->grid = *stop_grid_;
+
+        CatalogueImage image;
+        image.strings = storage->strings;
+        image.stops = storage->stops;
+        image.buses = storage->buses;
+        image.route_stops = storage->route_stops;
+        image.road_prefix = storage->road_prefix;
+        image.distances = storage->distances;
+        image.stops_by_name = storage->stops_by_name;
+        image.buses_by_name = storage->buses_by_name;
+        image.stop_index = storage->stop_index.GetTables();
+        image.bus_index = storage->bus_index.GetTables();
+        image.stop_bus_offsets = storage->stop_bus_offsets;
+        image.stop_bus_ids = storage->stop_bus_ids;
+        image.grid = storage->grid.GetImage();
+        image.storage = std::move(storage);
+        return image;
+    }
 
-        return empty_result;
+    TransportCatalogue TransportCatalogue::WithUpdate(const CatalogueUpdate& update, CatalogueDelta& delta) const {
+        if (!frozen_) {
+            throw std::logic_error("Transport catalogue is not frozen");
+        }
+        TransportCatalogue next(*this);
+        next.storages_.push_back(arena_);
+        next.arena_ = std::make_shared<std::pmr::monotonic_buffer_resource>();
+        delta = next.Apply(update);
+        if (next.garbage_bytes_ <= next.live_bytes_) {
+            return next;
+        }
+
+        // Заменённых объектов больше, чем живых: версия собирается заново
+        // по образу и перестаёт удерживать арены прежних версий. Номера
+        // записей в образе те же, поэтому указатели delta переводятся по ним
+        TransportCatalogue rebuilt(next.MakeImage());
+        for (const Stop*& stop : delta.added_stops) {
+            stop = (*rebuilt.all_stops_)[stop->id];
+        }
+        for (const Stop*& stop : delta.moved_stops) {
+            stop = (*rebuilt.all_stops_)[stop->id];
+        }
+        for (const Bus*& bus : delta.changed_buses) {
+            bus = (*rebuilt.all_buses_)[bus->id];
+        }
+        return rebuilt;
+    }
+
+    CatalogueDelta TransportCatalogue::Apply(const CatalogueUpdate& update) {
+        CatalogueDelta delta;
+        std::unordered_set<uint32_t> changed_buses;
+        // Маршруты через перенесённые остановки: у них новые указатели на
+        // остановки и новая географическая длина
+        std::unordered_set<uint32_t> reindexed_buses;
+        // Объекты маршрутов, созданные этой версией
+        std::unordered_map<uint32_t, Bus*> new_buses;
+
+        for (const auto& stop_update : update.stops) {
+            if (const Stop* stop = FindStop(stop_update.name)) {
+                if (const StopCoordinates coordinates(stop_update.coordinates); stop->coordinates != coordinates) {
+                    const Stop* moved = NewStop(stop->name, coordinates, stop->id);
+                    auto& grid = Mutable(stop_grid_);
+                    grid.Erase(stop->id, geo::ToDegrees(stop->coordinates));
+                    ReplaceStop(moved);
+                    grid.Insert(moved, *all_stops_);
+                    delta.moved_stops.push_back(moved);
+                    for (uint32_t bus_id : GetBusIds(stop->id)) {
+                        reindexed_buses.insert(bus_id);
+                    }
+                }
+            } else {
+                delta.added_stops.push_back(InsertStop(stop_update.name, stop_update.coordinates));
+            }
+        }
+
+        for (const auto& stop_update : update.stops) {
+            const Stop* from = FindStop(stop_update.name);
+            for (const auto& [to_name, distance] : stop_update.road_distances) {
+                const Stop* to = FindStop(to_name);
+                if (!to) continue;
+                if (const int* stored = FindDistance(from->id, to->id); stored && *stored == distance) continue;
+                // GetDistance(to, from) берёт это расстояние, если обратное не задано
+                updated_distances_[DistanceKey(from->id, to->id)] = distance;
+
+                // Участок может проходиться маршрутом в любом направлении
+                const std::span<const uint32_t> from_buses = GetBusIds(from->id);
+                const std::span<const uint32_t> to_buses = GetBusIds(to->id);
+                std::set_intersection(from_buses.begin(), from_buses.end(), to_buses.begin(), to_buses.end(),
+                                      std::inserter(changed_buses, changed_buses.end()));
+            }
+        }
+
+        for (const auto& bus_update : update.buses) {
+            const std::vector<const Stop*> stops = ResolveStops(bus_update.stops);
+            if (const Bus* bus = FindBus(bus_update.name)) {
+                for (const Stop* stop : bus->stops) {
+                    auto& ids = GetUpdatedBusIds(stop->id);
+                    if (auto it = std::lower_bound(ids.begin(), ids.end(), bus->id); it != ids.end() && *it == bus->id) {
+                        ids.erase(it);
+                    }
+                }
+                Bus* replaced = NewBus(bus->id, bus->name, stops, bus_update.is_roundtrip);
+                ReplaceBus(replaced);
+                for (const Stop* stop : replaced->stops) {
+                    auto& ids = GetUpdatedBusIds(stop->id);
+                    if (auto it = std::lower_bound(ids.begin(), ids.end(), replaced->id); it == ids.end() || *it != replaced->id) {
+                        ids.insert(it, replaced->id);
+                    }
+                }
+                new_buses[replaced->id] = replaced;
+                changed_buses.insert(replaced->id);
+            } else {
+                Bus* inserted = InsertBus(bus_update.name, stops, bus_update.is_roundtrip);
+                new_buses[inserted->id] = inserted;
+                changed_buses.insert(inserted->id);
+            }
+        }
+
+        // Прежний объект маршрута копируется с остановками этой версии;
+        // длины считаются заново у всех новых объектов
+        for (uint32_t id = 0; id < all_buses_->size(); ++id) {
+            const bool changed = changed_buses.count(id) > 0;
+            if (!changed && !reindexed_buses.count(id)) continue;
+            Bus* bus = nullptr;
+            if (auto it = new_buses.find(id); it != new_buses.end()) {
+                bus = it->second;
+            } else {
+                const Bus* old_bus = (*all_buses_)[id];
+                std::vector<const Stop*> stops;
+                stops.reserve(old_bus->stops.size());
+                for (const Stop* stop : old_bus->stops) {
+                    stops.push_back((*all_stops_)[stop->id]);
+                }
+                std::pmr::polymorphic_allocator<> alloc(arena_.get());
+                bus = alloc.new_object<Bus>(*old_bus);
+                bus->stops = StoreStops(stops);
+                ReplaceBus(bus);
+            }
+            IndexRoute(*bus);
+            live_bytes_ += BusBytes(*bus);
+            if (changed) {
+                delta.changed_buses.push_back(bus);
+            }
+        }
+        return delta;
+    }
+    bool TransportCatalogue::IsFrozen() const {
+        return frozen_;
+    }
+    void TransportCatalogue::CheckNotFrozen() const {
+        if (frozen_) {
+            throw std::logic_error("Transport catalogue is frozen");
+        }
     }
 }
@@ -1,25 +1,135 @@
 #pragma once
 //transport_catalogue.h
 #include "geo.h"
+#include "perfect_hash.h"
+#include "spatial_index.h"
+#include "id_set.h"
 #include <string>
 #include <string_view>
 #include <vector>
 #include <unordered_map>
-#include <deque>
 #include <unordered_set>
-#include <set>
+#include <span>
+#include <memory>
+#include <memory_resource>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
 #include <stdexcept>
 namespace transport {
 
+    // Сборка с -DTRANSPORT_MICRO_COORDINATES хранит координаты остановок
+    // целыми миллионными долями градуса; расстояния и проекция на карту
+    // переводят их в градусы сами (см. geo::ToDegrees)
+#ifdef TRANSPORT_MICRO_COORDINATES
+    using StopCoordinates = geo::MicroCoordinates;
+#else
+    using StopCoordinates = geo::Coordinates;
+#endif
+
+    // Имена и последовательности остановок хранятся в арене справочника,
+    // поэтому Stop и Bus ссылаются на них через string_view и span
     struct Stop {
-        std::string name;
-        geo::Coordinates coordinates;
+        std::string_view name;
+        StopCoordinates coordinates;
+        // Плотный номер остановки: позиция в GetAllStops()
+        uint32_t id = 0;
+    };
+
+    // Полный путь автобуса поверх хранимых остановок, без копирования.
+    // Некольцевой маршрут A-B-C хранится как три остановки, а обходится
+    // как A-B-C-B-A, или как A-B-C-C-B-A, если конечная повторяется
+    // (см. Bus::repeats_turnaround)
+    class RouteView {
+    public:
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = const Stop*;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Stop* const*;
+            using reference = const Stop* const&;
+
+            Iterator() = default;
+            Iterator(std::span<const Stop* const> stops, size_t index, size_t mirror)
+                : stops_(stops), index_(index), mirror_(mirror) {
+            }
+
+            reference operator*() const {
+                return index_ < stops_.size() ? stops_[index_] : stops_[mirror_ - index_];
+            }
+            Iterator& operator++() {
+                ++index_;
+                return *this;
+            }
+            Iterator operator++(int) {
+                Iterator copy = *this;
+                ++index_;
+                return copy;
+            }
+            bool operator==(const Iterator& other) const {
+                return index_ == other.index_;
+            }
+
+        private:
+            std::span<const Stop* const> stops_;
+            size_t index_ = 0;
+            // Обратный путь: элемент index берётся с позиции mirror_ - index
+            size_t mirror_ = 0;
+        };
+
+        RouteView(std::span<const Stop* const> stops, bool is_roundtrip, bool repeats_turnaround = false)
+            : stops_(stops)
+            , size_(is_roundtrip || stops.empty() ? stops.size()
+                                                  : 2 * stops.size() - (repeats_turnaround ? 0 : 1))
+            , mirror_(2 * stops.size() - (repeats_turnaround ? 1 : 2)) {
+        }
+
+        size_t size() const {
+            return size_;
+        }
+        bool empty() const {
+            return stops_.empty();
+        }
+        const Stop* operator[](size_t index) const {
+            return *Iterator(stops_, index, mirror_);
+        }
+        Iterator begin() const {
+            return {stops_, 0, mirror_};
+        }
+        Iterator end() const {
+            return {stops_, size_, mirror_};
+        }
+
+    private:
+        std::span<const Stop* const> stops_;
+        size_t size_;
+        size_t mirror_;
     };
 
     struct Bus {
-        std::string name;
-        std::vector<const Stop*> stops;
+        // Плотный номер маршрута: позиция в GetAllBuses()
+        uint32_t id = 0;
+        std::string_view name;
+        // Остановки в порядке описания: для некольцевого маршрута только путь
+        // в одну сторону, обратный путь даёт Route()
+        std::span<const Stop* const> stops;
         bool is_roundtrip = false;
+        // Конечная некольцевого маршрута проезжается дважды. Так бывает, когда
+        // последняя остановка в описании не задана в base_requests: путь
+        // сначала отражается, а потом из него выбрасываются неописанные
+        // остановки, и A-B-X превращается в A-B-B-A
+        bool repeats_turnaround = false;
+        // Заполняются в Freeze по таблице участков, а у маршрутов новой
+        // версии — в WithUpdate: дорожная длина пути от начала до каждой
+        // остановки (Route().size(), первый элемент — 0) и географическая
+        // длина всего пути
+        std::span<const double> road_prefix;
+        double geo_length = 0.0;
+
+        RouteView Route() const {
+            return {stops, is_roundtrip, repeats_turnaround};
+        }
     };
 
     struct BusInfo {
@@ -30,33 +140,289 @@ namespace transport {
         bool exists = false;
     };
 
+    struct BusStats {
+        const Bus* bus = nullptr;
+        BusInfo info;
+    };
+
+    // Сводка по всей сети. Средняя извилистость — среднее по маршрутам,
+    // у которых географическая длина не нулевая
+    struct NetworkStats {
+        int bus_count = 0;
+        int stop_count = 0;
+        int total_stops = 0;
+        double total_route_length = 0.0;
+        double mean_curvature = 0.0;
+        // Показатели каждого маршрута в порядке названий; пусто, если не запрошены
+        std::vector<BusStats> buses;
+    };
+
     struct PairHash{
         size_t operator()(const std::pair<const Stop* , const Stop* >& p) const {
             return std::hash<const void*>()(p.first) ^ std::hash<const void*>()(p.second);
         }
     };
 
+    // Добавленные или изменённые записи справочника в формате base_requests.
+    // Маршрут задаётся остановками из запроса, как в AddBus
+    struct StopUpdate {
+        std::string name;
+        geo::Coordinates coordinates;
+        std::vector<std::pair<std::string, int>> road_distances;
+    };
+
+    struct BusUpdate {
+        std::string name;
+        std::vector<std::string> stops;
+        bool is_roundtrip = false;
+    };
+
+    struct CatalogueUpdate {
+        std::vector<StopUpdate> stops;
+        std::vector<BusUpdate> buses;
+    };
+
+    // Результат WithUpdate: по нему зависимые структуры (маршрутизатор,
+    // кэши ответов) обновляют только затронутые части
+    struct CatalogueDelta {
+        std::vector<const Stop*> added_stops;
+        // Остановки с изменившимися координатами
+        std::vector<const Stop*> moved_stops;
+        // Новые и изменённые маршруты, а также маршруты, проходящие
+        // по участкам с изменившимся дорожным расстоянием
+        std::vector<const Bus*> changed_buses;
+
+        bool Empty() const {
+            return added_stops.empty() && moved_stops.empty() && changed_buses.empty();
+        }
+    };
+
+    // Замороженный справочник в виде плоских массивов без указателей:
+    // записи ссылаются на остановки и маршруты номерами, а имена — на срезы
+    // таблицы строк. По образу справочник собирается сразу замороженным:
+    // индексы имён, порядок по названию, списки маршрутов по остановкам,
+    // сетка остановок, длины маршрутов и расстояния берутся готовыми, и
+    // справочник читает их прямо из массивов образа
+    struct CatalogueImage {
+        struct NameRef {
+            uint32_t offset = 0;
+            uint32_t size = 0;
+        };
+
+        struct StopRecord {
+            NameRef name;
+            // Координаты в градусах
+            double lat = 0.0;
+            double lng = 0.0;
+        };
+
+        struct BusRecord {
+            NameRef name;
+            // Путь в одну сторону: срез route_stops
+            uint32_t stops_offset = 0;
+            uint32_t stops_count = 0;
+            // Нарастающие длины пути (Route().size() значений) с этой позиции road_prefix
+            uint32_t prefix_offset = 0;
+            uint8_t is_roundtrip = 0;
+            uint8_t repeats_turnaround = 0;
+            uint16_t reserved = 0;
+            double geo_length = 0.0;
+        };
+
+        struct DistanceRecord {
+            uint32_t from = 0;
+            uint32_t to = 0;
+            int32_t meters = 0;
+        };
+
+        std::string_view strings;
+        std::span<const StopRecord> stops;
+        std::span<const BusRecord> buses;
+        std::span<const uint32_t> route_stops;
+        std::span<const double> road_prefix;
+        // Заданные дорожные расстояния по возрастанию (from, to)
+        std::span<const DistanceRecord> distances;
+        // Номера остановок и маршрутов в порядке названий
+        std::span<const uint32_t> stops_by_name;
+        std::span<const uint32_t> buses_by_name;
+        // Совершенные хеш-индексы имён: позиция ключа — номер записи
+        perfect_hash::StringIndex::Tables stop_index;
+        perfect_hash::StringIndex::Tables bus_index;
+        // Номера маршрутов через остановку id по возрастанию:
+        // stop_bus_ids с stop_bus_offsets[id] по stop_bus_offsets[id + 1]
+        std::span<const uint32_t> stop_bus_offsets;
+        std::span<const uint32_t> stop_bus_ids;
+        spatial::StopGrid::Image grid;
+        // Память, в которой лежат массивы образа. Справочник, собранный по
+        // образу, держит её, пока жив сам
+        std::shared_ptr<const void> storage;
+    };
+
+    // Справочник заполняется через AddStop/AddBus/SetDistance, после чего
+    // фиксируется вызовом Freeze(), либо собирается готовым по образу.
+    // Замороженный справочник не меняется никогда: WithUpdate строит по нему
+    // следующую версию, а он сам остаётся прежним. Он не содержит
+    // mutable-состояния и ленивых вычислений, поэтому его константные методы
+    // можно вызывать из любого числа потоков без синхронизации, в том числе
+    // пока по нему строится следующая версия.
+    //
+    // Записи ссылаются друг на друга указателями, а индексы замороженного
+    // справочника — номерами записей; индексы лежат плоскими массивами
+    // в арене справочника или в памяти образа. Имена, последовательности
+    // остановок и сами записи размещаются в монотонной арене, которая
+    // освобождается целиком вместе с последней версией, ссылающейся на неё;
+    // словари времени загрузки освобождает Freeze. Справочник можно
+    // перемещать, но не копировать.
+    //
+    // Версии делят неизменившиеся данные: записи, строки, индексы имён,
+    // таблицы расстояний и списков маршрутов общие, а таблицы указателей и
+    // сетка остановок копируются только той версией, которая их меняет.
+    // Изменённая остановка или маршрут получают в новой версии новый объект
+    // с прежним номером. Заменённые объекты остаются в арене, пока живы
+    // ссылающиеся на неё версии; когда их становится больше, чем живых
+    // данных, следующая версия собирается заново по образу (см. MakeImage)
     class TransportCatalogue {
     public:
-        void AddStop(const std::string& name, geo::Coordinates coordinates);
-        void AddBus(const std::string& name, const std::vector<std::string>& stop_names, bool is_roundtrip);
+        TransportCatalogue();
+        // Собирает замороженный справочник по образу; массивы образа не
+        // копируются. Если образ не согласован (номера за пределами массивов,
+        // срезы за пределами таблицы строк), бросается std::invalid_argument
+        explicit TransportCatalogue(const CatalogueImage& image);
+        TransportCatalogue(TransportCatalogue&&) = default;
+        TransportCatalogue& operator=(TransportCatalogue&&) = default;
+
+        // Резервирует место под заранее известное число записей
+        void Reserve(size_t stop_count, size_t bus_count, size_t distance_count);
+
+        // Возвращает копию строки в арене справочника. До Freeze одинаковые
+        // строки хранятся один раз, поэтому имя, встреченное в ссылке раньше
+        // описания, не копируется повторно
+        std::string_view Intern(std::string_view str);
+
+        const Stop* AddStop(std::string_view name, geo::Coordinates coordinates);
+        // Некольцевой маршрут задаётся путём в одну сторону.
+        // Остановки с неизвестными названиями (в перегрузке с указателями —
+        // nullptr) пропускаются так же, как если бы их выбросили из уже
+        // отражённого пути (см. Bus::repeats_turnaround)
+        void AddBus(std::string_view name, const std::vector<std::string>& stop_names, bool is_roundtrip);
+        void AddBus(std::string_view name, std::span<const Stop* const> stops, bool is_roundtrip);
         void SetDistance(const Stop* from, const Stop*  to, int distance);
         const Stop* FindStop(std::string_view name) const;
         const Bus* FindBus(std::string_view name) const;
-        const std::set<std::string>& GetBusesForStop(std::string_view stop_name) const;
+        // Маршруты через остановку в порядке названий (доступно после Freeze)
+        std::vector<const Bus*> GetBusesForStop(std::string_view stop_name) const;
+        // Маршруты, проходящие через все указанные остановки, в порядке
+        // названий (доступно после Freeze)
+        std::vector<const Bus*> GetCommonBuses(std::span<const Stop* const> stops) const;
         BusInfo GetBusInfo(std::string_view name) const;
+        BusInfo GetBusInfo(const Bus* bus) const;
+        // Показатели всех маршрутов считаются параллельно по потокам и затем
+        // суммируются в порядке названий, так что результат не зависит от
+        // числа потоков (доступно после Freeze)
+        NetworkStats GetNetworkStats(bool with_buses) const;
         int GetDistance(const Stop* from , const Stop* to) const;
-        const std::deque<const Bus*>& GetAllBuses() const;
-        const std::deque<const Stop*>& GetAllStops() const;
+        // Все маршруты и остановки в порядке добавления; доступны и до Freeze
+        const std::vector<const Bus*>& GetAllBuses() const;
+        const std::vector<const Stop*>& GetAllStops() const;
+        // Маршруты, упорядоченные по названию (доступно после Freeze)
+        const std::vector<const Bus*>& GetBusesSortedByName() const;
+        // Не более count остановок или маршрутов, названия которых начинаются
+        // с prefix, в порядке названий (доступно после Freeze)
+        std::vector<const Stop*> SearchStops(std::string_view prefix, size_t count) const;
+        std::vector<const Bus*> SearchBuses(std::string_view prefix, size_t count) const;
+        // Не более count ближайших к точке остановок и все остановки в радиусе
+        // radius метров, по возрастанию расстояния (доступно после Freeze)
+        std::vector<spatial::NearbyStop> FindNearestStops(geo::Coordinates center, size_t count) const;
+        std::vector<spatial::NearbyStop> FindStopsWithin(geo::Coordinates center, double radius) const;
+
+        // Завершает загрузку: по таблице участков, общей для всех маршрутов,
+        // считает нарастающие длины маршрутов, строит сетку остановок,
+        // упорядоченные по названию массивы для поиска по префиксу, списки
+        // номеров маршрутов по остановкам, упорядоченную таблицу расстояний
+        // и совершенные хеш-индексы имён для FindStop/FindBus.
+        // После вызова любые попытки изменить справочник бросают std::logic_error
+        void Freeze();
+        bool IsFrozen() const;
+        // Образ замороженного справочника.
+        // Массивы образа лежат в его storage
+        CatalogueImage MakeImage() const;
+
+        // Следующая версия замороженного справочника с изменениями update;
+        // сам справочник не меняется. Указатели в delta относятся к новой
+        // версии; номера остановок и маршрутов в версиях совпадают, поэтому
+        // зависимые структуры могут хранить номера. Имена, которых не было в
+        // совершенных хеш-индексах, попадают в дополнительный индекс.
+        // До Freeze бросает std::logic_error
+        TransportCatalogue WithUpdate(const CatalogueUpdate& update, CatalogueDelta& delta) const;
     private:
-        std::deque<Stop> stops_;
-        std::deque<Bus> buses_;
-        std::unordered_map<std::string_view, const Stop*> stop_name_to_stop_;
-        std::unordered_map<std::string_view, const Bus*> bus_name_to_bus_;
-        std::unordered_map<const Stop*,std::set<std::string>> stop_to_buses_;
-        std::unordered_map<std::pair<const Stop*, const Stop*>,int , PairHash> distance_;
+        // Версия копирует только таблицы и дополнительные индексы; общие
+        // части делятся через shared_ptr. Используется в WithUpdate
+        TransportCatalogue(const TransportCatalogue&) = default;
+
+        void CheckNotFrozen() const;
+        Stop* NewStop(std::string_view name, StopCoordinates coordinates, uint32_t id);
+        const Stop* InsertStop(std::string_view name, geo::Coordinates coordinates);
+        Bus* NewBus(uint32_t id, std::string_view name, std::span<const Stop* const> stops, bool is_roundtrip);
+        Bus* InsertBus(std::string_view name, std::span<const Stop* const> stops, bool is_roundtrip);
+        std::span<const Stop* const> StoreStops(std::span<const Stop* const> stops);
+        std::vector<const Stop*> ResolveStops(const std::vector<std::string>& stop_names) const;
+        // Нарастающие длины маршрута без таблицы участков
+        void IndexRoute(Bus& bus);
+        // Вносит update в эту, ещё не опубликованную версию
+        CatalogueDelta Apply(const CatalogueUpdate& update);
+        // Заменяет объект остановки или маршрута с тем же номером
+        void ReplaceStop(const Stop* stop);
+        void ReplaceBus(const Bus* bus);
+        // Номера маршрутов через остановку по возрастанию (после Freeze)
+        std::span<const uint32_t> GetBusIds(uint32_t stop_id) const;
+        std::vector<uint32_t>& GetUpdatedBusIds(uint32_t stop_id);
+        // Заданное расстояние from -> to в замороженном справочнике или nullptr
+        const int* FindDistance(uint32_t from, uint32_t to) const;
+        template <typename T>
+        std::span<const T> CopyToArena(const std::vector<T>& items);
+        // Объём записей и массивов, на которые ссылается версия, в байтах
+        size_t CountLiveBytes() const;
+
+        // Хранилища объявлены первыми, чтобы разрушаться последними:
+        // память, на которую ссылаются записи и индексы, — арены прежних
+        // версий, образ или отображённый файл, — и собственная арена версии
+        std::vector<std::shared_ptr<const void>> storages_;
+        std::string_view external_bytes_;
+        std::shared_ptr<std::pmr::monotonic_buffer_resource> arena_;
+        // Строки, уже скопированные в арену (освобождается в Freeze)
+        std::unordered_set<std::string_view> interned_;
+        // Маршруты, которым Freeze ещё должен посчитать длины
+        std::vector<Bus*> loading_buses_;
+        // Таблицы, которые версия копирует, только если меняет
+        std::shared_ptr<std::vector<const Stop*>> all_stops_;
+        std::shared_ptr<std::vector<const Bus*>> all_buses_;
+        // Номера записей по именам на время загрузки; после Freeze их
+        // заменяют совершенные хеш-индексы, позиция имени в которых — номер
+        // записи, а в словарях остаются только имена, добавленные через WithUpdate
+        std::unordered_map<std::string_view, uint32_t> stop_ids_;
+        std::unordered_map<std::string_view, uint32_t> bus_ids_;
+        std::shared_ptr<const perfect_hash::StringIndex> stop_index_;
+        std::shared_ptr<const perfect_hash::StringIndex> bus_index_;
+        // Дорожные расстояния на время загрузки (освобождается в Freeze)
+        std::unordered_map<std::pair<const Stop*, const Stop*>, int, PairHash> loading_distances_;
+        // После Freeze: расстояния по возрастанию (from, to) и расстояния,
+        // заданные через WithUpdate, по паре номеров (from << 32 | to)
+        std::span<const CatalogueImage::DistanceRecord> distances_;
+        std::unordered_map<uint64_t, int> updated_distances_;
+        // Номера маршрутов через остановку по возрастанию, как в
+        // CatalogueImage. Списки, изменённые через WithUpdate, и списки новых
+        // остановок лежат в updated_stop_buses_ и заменяют прежние
+        std::span<const uint32_t> stop_bus_offsets_;
+        std::span<const uint32_t> stop_bus_ids_;
+        std::unordered_map<uint32_t, std::vector<uint32_t>> updated_stop_buses_;
+        std::shared_ptr<spatial::StopGrid> stop_grid_;
 
-        mutable std::deque<const Stop*> all_stops_;
-        mutable std::deque<const Bus*> all_buses_;
+        std::shared_ptr<std::vector<const Stop*>> stops_by_name_;
+        std::shared_ptr<std::vector<const Bus*>> buses_by_name_;
+        // Объём данных версии и заменённых объектов, которые версия
+        // удерживает в общих аренах
+        size_t live_bytes_ = 0;
+        size_t garbage_bytes_ = 0;
+        bool frozen_ = false;
     };
-}
+}
\ No newline at end of file
@@ -2,22 +2,26 @@
 
 namespace transport_router {
   TransportRouter::TransportRouter( const transport::TransportCatalogue& catalogue,
-                                    const RoutingSettings& settings): catalogue_(catalogue), settings_(settings),
+                                    const RoutingSettings& settings): catalogue_(&catalogue), settings_(settings),
                                     graph_(catalogue.GetAllStops().size()) {
   BuildGraph();
   router_ = std::make_unique<graph::Router<double>>(graph_);
   }
+  TransportRouter::TransportRouter(const TransportRouter& base, const transport::TransportCatalogue& catalogue,
+                                   const transport::CatalogueDelta& delta)
+      : catalogue_(base.catalogue_), settings_(base.settings_), graph_(base.graph_),
+        router_(std::make_unique<graph::Router<double>>(*base.router_, graph_)),
+        edges_info_(base.edges_info_), stop_vertices_(base.stop_vertices_), bus_edges_(base.bus_edges_) {
+    Update(catalogue, delta);
+  }
   std::optional<RouteInfo> TransportRouter:: GetOptimalRoute(const transport::Stop* from, const transport::Stop* to) const {
        // 1. Найти вершины по остановкам
-       auto it_from = stop_to_vertex_id_.find(from);
-       auto it_to = stop_to_vertex_id_.find(to);
-
-       if (it_from == stop_to_vertex_id_.end() || it_to == stop_to_vertex_id_.end()) {
+       if (!from || !to || from->id >= stop_vertices_.size() || to->id >= stop_vertices_.size()) {
            return std::nullopt;
        }
 
-       graph::VertexId from_id = it_from->second;
-       graph::VertexId to_id = it_to->second;
+       graph::VertexId from_id = stop_vertices_[from->id].arrival;
+       graph::VertexId to_id = stop_vertices_[to->id].arrival;
 
        // 2. Вызвать маршрутизатор
        auto route = router_->BuildRoute(from_id, to_id);
@@ -36,13 +40,14 @@ namespace transport_router {
 
            RouteItem item;
            item.time = edge.weight;
-           item.name = edge_info.name;
 
            if (edge_info.type == EdgeInfo::Type::Wait) {
                item.type = RouteItem::Type::Wait;
+               item.name = catalogue_->GetAllStops()[edge_info.id]->name;
                item.span_count = 0;
            } else if (edge_info.type == EdgeInfo::Type::Bus) {
                item.type = RouteItem::Type::Bus;
+               item.name = catalogue_->GetAllBuses()[edge_info.id]->name;
                item.span_count = edge_info.span_count;
            }
 
@@ -51,73 +56,124 @@ namespace transport_router {
 
        return route_info;
   }
-  void TransportRouter::AddWaitEdges(int stop_count) {
-    for (const auto& [stop, arrival] : stop_to_vertex_id_) {
-        const graph::VertexId dep = arrival + stop_count;
-        graph_.AddEdge({arrival, dep, static_cast<double>(settings_.bus_wait_time)});
-        edges_info_.push_back({EdgeInfo::Type::Wait, stop->name, 0});
-    }
+  graph::EdgeId TransportRouter::AddWaitEdge(const transport::Stop* stop, const StopVertices& vertices) {
+    const graph::EdgeId id = graph_.AddEdge({vertices.arrival, vertices.departure,
+                                             static_cast<double>(settings_.bus_wait_time)});
+    edges_info_.push_back({EdgeInfo::Type::Wait, stop->id, 0});
+    return id;
 }
-void TransportRouter::AddBusEdges(const std::vector<const transport::Stop*>& stops, const std::string& bus_name, bool forward, int stop_count) {
-  int n = static_cast<int>(stops.size());
-
-  if (forward) {
-      for (int i = 0; i < n - 1; ++i) {
-          AddBusSpanEdges(i, n, 1, stops, bus_name, stop_count, true);
-      }
-  } else {
-      for (int i = n - 1; i > 0; --i) {
-          AddBusSpanEdges(i, -1, -1, stops, bus_name, stop_count, false);
-      }
+// Полный путь некольцевого маршрута симметричен (A-B-C-B-A), поэтому одного
+// прохода вперёд достаточно: обход в обратную сторону дал бы те же рёбра
+void TransportRouter::AddBusEdges(const transport::Bus* bus) {
+  if (bus->id >= bus_edges_.size()) {
+      bus_edges_.resize(bus->id + 1);
+  }
+  auto& edges = bus_edges_[bus->id];
+  const transport::RouteView route = bus->Route();
+  if (route.size() < 2) return;
+
+  int n = static_cast<int>(route.size());
+  for (int i = 0; i < n - 1; ++i) {
+      AddBusSpanEdges(i, route, bus, edges);
   }
 }
 
-void TransportRouter::AddBusSpanEdges(int start, int end, int step,
-  const std::vector<const transport::Stop*>& stops,
-  const std::string& bus_name, int stop_count, bool forward) {
+// Длина поездки от start до j — разность нарастающих длин маршрута
+void TransportRouter::AddBusSpanEdges(int start, const transport::RouteView& stops,
+  const transport::Bus* bus, std::vector<graph::EdgeId>& edges) {
 
-  double dist_sum = 0.0;
+  const auto& road_prefix = bus->road_prefix;
+  const graph::VertexId from = stop_vertices_[stops[start]->id].departure;
   int span = 1;
 
-  for (int j = start + step; j != end; j += step, ++span) {
-      dist_sum += forward
-          ? catalogue_.GetDistance(stops[j - 1], stops[j])
-          : catalogue_.GetDistance(stops[j + 1], stops[j]);
-
-      graph_.AddEdge({
-          stop_to_vertex_id_[stops[start]] + stop_count,
-          stop_to_vertex_id_[stops[j]],
-          ConvertDistanceToTime(dist_sum)
-      });
+  for (int j = start + 1; j != static_cast<int>(stops.size()); ++j, ++span) {
+      edges.push_back(graph_.AddEdge({
+          from,
+          stop_vertices_[stops[j]->id].arrival,
+          ConvertDistanceToTime(road_prefix[j] - road_prefix[start])
+      }));
 
-      edges_info_.push_back({EdgeInfo::Type::Bus, bus_name, span});
+      edges_info_.push_back({EdgeInfo::Type::Bus, bus->id, span});
   }
 }
   void TransportRouter::BuildGraph() {
-      // 0. Пронумеровали остановки
-    int stop_count = 0;
-    for (const auto* stop : catalogue_.GetAllStops()) {
-        stop_to_vertex_id_[stop] = stop_count++;
+      // 0. Пронумеровали остановки: сначала вершины прибытия, затем отправления
+    const auto& stops = catalogue_->GetAllStops();
+    const graph::VertexId stop_count = stops.size();
+    stop_vertices_.resize(stop_count);
+    for (graph::VertexId id = 0; id < stop_count; ++id) {
+        stop_vertices_[id] = {id, id + stop_count};
     }
 
     // 1. Инициализируем граф
     graph_ = graph::DirectedWeightedGraph<double>(stop_count * 2);
 
     // 2. Добавим рёбра ожидания (Wait)
-    AddWaitEdges(stop_count);
+    for (const transport::Stop* stop : stops) {
+        AddWaitEdge(stop, stop_vertices_[stop->id]);
+    }
 
     // 3. Добавим рёбра движения по автобусам (Bus)
-    for (const transport::Bus* bus : catalogue_.GetAllBuses()) {
-        const auto& stops = bus->stops;
-        if (stops.size() < 2) continue;
-
-        const std::string& bus_name = bus->name;
-        AddBusEdges(stops, bus_name, true, stop_count);
-        if (!bus->is_roundtrip) {
-            AddBusEdges(stops, bus_name, false, stop_count);
+    bus_edges_.resize(catalogue_->GetAllBuses().size());
+    for (const transport::Bus* bus : catalogue_->GetAllBuses()) {
+        AddBusEdges(bus);
+    }
+}
+
+  void TransportRouter::Update(const transport::TransportCatalogue& catalogue, const transport::CatalogueDelta& delta) {
+    catalogue_ = &catalogue;
+    std::vector<graph::EdgeId> removed_edges;
+    std::vector<graph::EdgeId> added_edges;
+
+    // Новые остановки получают вершины в конце графа, не сдвигая старые
+    stop_vertices_.resize(catalogue.GetAllStops().size());
+    for (const transport::Stop* stop : delta.added_stops) {
+        const StopVertices vertices{graph_.AddVertex(), graph_.AddVertex()};
+        stop_vertices_[stop->id] = vertices;
+        added_edges.push_back(AddWaitEdge(stop, vertices));
+    }
+
+    // Рёбра изменённых маршрутов строим заново
+    for (const transport::Bus* bus : delta.changed_buses) {
+        if (bus->id < bus_edges_.size()) {
+            for (graph::EdgeId edge_id : bus_edges_[bus->id]) {
+                graph_.RemoveEdge(edge_id);
+                removed_edges.push_back(edge_id);
+            }
+            bus_edges_[bus->id].clear();
         }
+        AddBusEdges(bus);
+        const auto& edges = bus_edges_[bus->id];
+        added_edges.insert(added_edges.end(), edges.begin(), edges.end());
+    }
+
+    router_->Update(removed_edges, added_edges);
+    if (graph_.GetRemovedEdgeCount() * 2 > graph_.GetEdgeCount()) {
+        CompactGraph();
     }
 }
 
-}// namespace transport_router
+  // Убирает из графа удалённые рёбра и переводит на новые номера всё,
+  // что на них ссылается
+  void TransportRouter::CompactGraph() {
+    const std::vector<graph::EdgeId> new_ids = graph_.Compact();
+    router_->RemapEdges(new_ids);
+
+    // Compact сохраняет порядок живых рёбер
+    std::vector<EdgeInfo> edges_info;
+    edges_info.reserve(graph_.GetEdgeCount());
+    for (graph::EdgeId edge_id = 0; edge_id < new_ids.size(); ++edge_id) {
+        if (new_ids[edge_id] != graph::NO_EDGE) {
+            edges_info.push_back(edges_info_[edge_id]);
+        }
+    }
+    edges_info_ = std::move(edges_info);
 
+    for (auto& edges : bus_edges_) {
+        for (graph::EdgeId& edge_id : edges) {
+            edge_id = new_ids[edge_id];
+        }
+    }
+}
+
+}// namespace transport_router
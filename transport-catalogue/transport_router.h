@@ -1,9 +1,11 @@
 #pragma once
 // transport_router.h
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <optional>
-#include <unordered_map>
+#include <span>
+#include <string_view>
 #include <vector>
 
 #include "transport_catalogue.h"
@@ -27,7 +29,7 @@ namespace transport_router {
 struct EdgeInfo {
   enum class Type { Wait, Bus };
   Type type;
-  std::string name; // имя остановки (для Wait) или автобуса (для Bus)
+  uint32_t id; // номер остановки (для Wait) или маршрута (для Bus) в справочнике
   int span_count = 0; // для автобуса, количество остановок
 };
 
@@ -36,30 +38,58 @@ struct RouteInfo {
     std::vector<RouteItem> items;
 };
 
+  // Строится по замороженному справочнику: веса рёбер берутся из
+  // нарастающих длин маршрутов (Bus::road_prefix). Остановки и маршруты
+  // известны маршрутизатору по номерам, которые не меняются от версии к
+  // версии справочника
   class TransportRouter{
   public:
     TransportRouter( const transport::TransportCatalogue& catalogue,
                      const RoutingSettings& settings);
+    // Следующая версия маршрутизатора для catalogue, построенного WithUpdate
+    // с изменениями delta. base не меняется и продолжает отвечать по прежней
+    // версии справочника; таблица маршрутов у них общая, пока строку не
+    // пересчитает одна из сторон
+    TransportRouter(const TransportRouter& base, const transport::TransportCatalogue& catalogue,
+                    const transport::CatalogueDelta& delta);
+    // router_ ссылается на graph_
+    TransportRouter(const TransportRouter&) = delete;
+    TransportRouter& operator=(const TransportRouter&) = delete;
     std::optional<RouteInfo> GetOptimalRoute(const transport::Stop* from, const transport::Stop* to) const;
 
+    // Переходит на версию справочника catalogue, построенную WithUpdate с
+    // изменениями delta: перестраивает рёбра только затронутых маршрутов и
+    // новых остановок и пересчитывает только те строки таблицы маршрутов,
+    // которые от них зависят. Когда удалённых рёбер становится больше, чем
+    // живых, граф уплотняется, так что он занимает не больше чем вдвое против
+    // построенного заново
+    void Update(const transport::TransportCatalogue& catalogue, const transport::CatalogueDelta& delta);
+
     private:
+    struct StopVertices {
+      graph::VertexId arrival;
+      graph::VertexId departure;
+    };
+
     void BuildGraph();
-    void AddBusSpanEdges(int start, int end, int step,
-      const std::vector<const transport::Stop*>& stops,
-      const std::string& bus_name, int stop_count, bool forward);
-    void AddBusEdges(const std::vector<const transport::Stop*>& stops, const std::string& bus_name, bool forward, int stop_count);
-    void AddWaitEdges(int stop_count);
+    void AddBusSpanEdges(int start, const transport::RouteView& stops,
+      const transport::Bus* bus, std::vector<graph::EdgeId>& edges);
+    void AddBusEdges(const transport::Bus* bus);
+    graph::EdgeId AddWaitEdge(const transport::Stop* stop, const StopVertices& vertices);
+    void CompactGraph();
 
     double ConvertDistanceToTime(double distance_meters) const {
       return distance_meters / (settings_.bus_velocity * 1000.0 / 60.0);
     }
 
-    const transport::TransportCatalogue& catalogue_;
+    const transport::TransportCatalogue* catalogue_;
     RoutingSettings settings_;
     graph::DirectedWeightedGraph<double> graph_;
     std::unique_ptr<graph::Router<double>> router_;
 
     std::vector<EdgeInfo> edges_info_;
-    std::unordered_map<const transport::Stop*, graph::VertexId> stop_to_vertex_id_;
+    // По номерам остановок и маршрутов
+    std::vector<StopVertices> stop_vertices_;
+    std::vector<std::vector<graph::EdgeId>> bus_edges_;
   };
 }// namespace transport_router